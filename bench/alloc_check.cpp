@@ -0,0 +1,188 @@
+// Allocation check: drives the real Game loop, rendering into an offscreen
+// pseudo-terminal, and fails if any frame after warm-up touches the heap.
+// Global operator new/delete are replaced with counting versions; only the
+// game thread is counted, not the thread draining the pty.
+#include "game.h"
+#include "metrics.h"
+#include "pty.h"
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <random>
+
+#include <pthread.h>
+#include <unistd.h>
+
+namespace
+{
+    std::atomic<uint64_t> g_allocs{0};
+    const pthread_t g_gameThread = pthread_self();
+
+    void count()
+    {
+        if (pthread_equal(pthread_self(), g_gameThread))
+            g_allocs.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void *counted(std::size_t n)
+    {
+        count();
+        if (void *p = std::malloc(n ? n : 1))
+            return p;
+        throw std::bad_alloc();
+    }
+}
+
+void *operator new(std::size_t n) { return counted(n); }
+void *operator new[](std::size_t n) { return counted(n); }
+void *operator new(std::size_t n, const std::nothrow_t &) noexcept
+{
+    count();
+    return std::malloc(n ? n : 1);
+}
+void *operator new[](std::size_t n, const std::nothrow_t &) noexcept
+{
+    count();
+    return std::malloc(n ? n : 1);
+}
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete[](void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::size_t) noexcept { std::free(p); }
+
+namespace
+{
+    struct Check
+    {
+        uint64_t frame{0};
+        uint64_t warmup{0};
+        uint64_t last{0};
+        uint64_t badFrames{0};
+        uint64_t badAllocs{0};
+        uint64_t firstBad{0};
+    };
+
+    void onFrame(void *ctx)
+    {
+        Check &c = *static_cast<Check *>(ctx);
+        uint64_t now = g_allocs.load(std::memory_order_relaxed);
+        uint64_t delta = now - c.last;
+        c.last = now;
+        ++c.frame;
+        if (c.frame > c.warmup && delta != 0)
+        {
+            if (c.badFrames == 0)
+                c.firstBad = c.frame;
+            ++c.badFrames;
+            c.badAllocs += delta;
+        }
+    }
+
+    void usage(const char *argv0)
+    {
+        std::fprintf(stderr, "usage: %s [--minutes N] [--warmup FRAMES] [--seed N] [--headless | --tty]\n"
+                             "  --minutes N  virtual minutes of play (default 30)\n"
+                             "  --warmup F   frames allowed to allocate (default 2000)\n"
+                             "  --headless   skip rendering (default: render into an offscreen pty)\n"
+                             "  --tty        render to this terminal instead\n",
+                     argv0);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    int minutes = 30;
+    uint64_t warmup = 2000;
+    unsigned seed = 1;
+    bool headless = false, tty = false;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--minutes") == 0 && i + 1 < argc)
+            minutes = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--warmup") == 0 && i + 1 < argc)
+            warmup = std::strtoull(argv[++i], nullptr, 0);
+        else if (std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+            seed = (unsigned)std::strtoul(argv[++i], nullptr, 0);
+        else if (std::strcmp(argv[i], "--headless") == 0)
+            headless = true;
+        else if (std::strcmp(argv[i], "--tty") == 0)
+            tty = true;
+        else
+        {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    // Script: accept the name, then random WASD turns and periodic Enter,
+    // which restarts after a game over (and is ignored while playing).
+    // WASD is used because arrows move the dialog selection.
+    VirtualClock clock;
+    ScriptedInput script(clock);
+    std::mt19937 rng(seed);
+    const char turns[] = {'w', 'a', 's', 'd'};
+    script.push(0, '\n');
+    const int64_t endMs = (int64_t)minutes * 60 * 1000;
+    for (int64_t t = 200; t < endMs; t += 200 + rng() % 600)
+    {
+        script.push(t, (uint32_t)turns[rng() % 4]);
+        if (rng() % 4 == 0)
+            script.push(t + 1, '\n');
+    }
+
+    Game game(80, 30);
+    game.setLeaderboardFile("");
+    game.setHistoryFile("");
+    game.setSaveFile("");
+    game.setReplayDir("");
+    game.setSeed(seed);
+    game.setClock(clock);
+    game.setInputSource(script);
+    game.setHeadless(headless);
+    Check check;
+    check.warmup = warmup;
+    check.last = g_allocs.load();
+    game.setFrameHook(onFrame, &check);
+
+    // The game draws to stdout and may read query replies from stdin:
+    // point both at the pty for the run, then put them back for the report
+    term::PtySink sink;
+    int savedIn = -1, savedOut = -1;
+    if (!headless && !tty)
+    {
+        setenv("TERM", "xterm-256color", 1);
+        if (!sink.open(40, 200))
+        {
+            std::fprintf(stderr, "cannot open a pseudo-terminal\n");
+            return 1;
+        }
+        std::fflush(stdout);
+        savedIn = dup(STDIN_FILENO);
+        savedOut = dup(STDOUT_FILENO);
+        dup2(sink.slaveFd(), STDIN_FILENO);
+        dup2(sink.slaveFd(), STDOUT_FILENO);
+    }
+    int score = game.run();
+    if (savedOut >= 0)
+    {
+        std::fflush(stdout);
+        dup2(savedIn, STDIN_FILENO);
+        dup2(savedOut, STDOUT_FILENO);
+        sink.close();
+        std::printf("rendered %llu bytes into a 40x200 pty\n", (unsigned long long)sink.bytes());
+    }
+
+    std::printf("frames=%llu ticks=%llu warmup=%llu score=%d allocating_frames=%llu allocations=%llu\n",
+                (unsigned long long)check.frame, (unsigned long long)metrics().ticks.load(),
+                (unsigned long long)check.warmup, score,
+                (unsigned long long)check.badFrames, (unsigned long long)check.badAllocs);
+    if (check.badFrames)
+    {
+        std::printf("FAIL: first allocating frame after warm-up: %llu\n", (unsigned long long)check.firstBad);
+        return 1;
+    }
+    std::printf("OK: steady-state frames are allocation-free\n");
+    return 0;
+}
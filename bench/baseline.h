@@ -0,0 +1,159 @@
+// Benchmark baselines: save per-sample results to a versioned text file and
+// compare a new run against it with Welch's t-test
+#pragma once
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace bench
+{
+    // File format (one benchmark per line, samples in ns/op):
+    //   # bytehebi-bench-baseline 1
+    //   suite <name>
+    //   commit <git short sha or "unknown">
+    //   bench <id> <sample> <sample> ...
+    constexpr int baselineVersion = 1;
+
+    struct Baseline
+    {
+        std::string suite;
+        std::string commit;
+        std::map<std::string, std::vector<double>> samples;
+    };
+
+    inline std::string gitCommit()
+    {
+        std::string sha = "unknown";
+        if (FILE *p = popen("git rev-parse --short HEAD 2>/dev/null", "r"))
+        {
+            char buf[64] = {0};
+            if (std::fgets(buf, sizeof buf, p))
+            {
+                sha = buf;
+                while (!sha.empty() && (sha.back() == '\n' || sha.back() == '\r'))
+                    sha.pop_back();
+            }
+            pclose(p);
+        }
+        return sha.empty() ? "unknown" : sha;
+    }
+
+    inline bool loadBaseline(const std::string &path, Baseline &b, std::string &err)
+    {
+        std::ifstream in(path);
+        if (!in.good())
+        {
+            err = "cannot read " + path;
+            return false;
+        }
+        std::string line;
+        if (!std::getline(in, line))
+        {
+            err = path + ": empty file";
+            return false;
+        }
+        int version = 0;
+        if (std::sscanf(line.c_str(), "# bytehebi-bench-baseline %d", &version) != 1)
+        {
+            err = path + ": not a baseline file";
+            return false;
+        }
+        if (version != baselineVersion)
+        {
+            err = path + ": baseline version " + std::to_string(version) + ", expected " +
+                  std::to_string(baselineVersion);
+            return false;
+        }
+        while (std::getline(in, line))
+        {
+            std::istringstream ls(line);
+            std::string kind;
+            ls >> kind;
+            if (kind == "suite")
+                ls >> b.suite;
+            else if (kind == "commit")
+                ls >> b.commit;
+            else if (kind == "bench")
+            {
+                std::string id;
+                ls >> id;
+                std::vector<double> v;
+                double x;
+                while (ls >> x)
+                    v.push_back(x);
+                b.samples[id] = v;
+            }
+        }
+        return true;
+    }
+
+    // Regularized incomplete beta I_x(a, b) (continued fraction, Lentz)
+    inline double incompleteBeta(double a, double b, double x)
+    {
+        if (x <= 0.0)
+            return 0.0;
+        if (x >= 1.0)
+            return 1.0;
+        if (x > (a + 1.0) / (a + b + 2.0))
+            return 1.0 - incompleteBeta(b, a, 1.0 - x);
+        double lbeta = std::lgamma(a + b) - std::lgamma(a) - std::lgamma(b);
+        double front = std::exp(std::log(x) * a + std::log(1.0 - x) * b + lbeta) / a;
+        const double tiny = 1e-300;
+        double f = 1.0, c = 1.0, d = 0.0;
+        for (int i = 0; i <= 400; ++i)
+        {
+            int m = i / 2;
+            double num;
+            if (i == 0)
+                num = 1.0;
+            else if (i % 2 == 0)
+                num = (m * (b - m) * x) / ((a + 2.0 * m - 1.0) * (a + 2.0 * m));
+            else
+                num = -((a + m) * (a + b + m) * x) / ((a + 2.0 * m) * (a + 2.0 * m + 1.0));
+            d = 1.0 + num * d;
+            if (std::fabs(d) < tiny)
+                d = tiny;
+            d = 1.0 / d;
+            c = 1.0 + num / c;
+            if (std::fabs(c) < tiny)
+                c = tiny;
+            double cd = c * d;
+            f *= cd;
+            if (std::fabs(1.0 - cd) < 1e-12)
+                break;
+        }
+        return front * (f - 1.0);
+    }
+
+    // Two-sided p-value of Welch's unequal-variance t-test
+    inline double welchP(const std::vector<double> &a, const std::vector<double> &b)
+    {
+        auto moments = [](const std::vector<double> &v, double &mean, double &var)
+        {
+            mean = 0;
+            for (double x : v)
+                mean += x;
+            mean /= (double)v.size();
+            var = 0;
+            for (double x : v)
+                var += (x - mean) * (x - mean);
+            var /= (double)(v.size() - 1);
+        };
+        if (a.size() < 2 || b.size() < 2)
+            return 1.0;
+        double ma, va, mb, vb;
+        moments(a, ma, va);
+        moments(b, mb, vb);
+        double sa = va / (double)a.size(), sb = vb / (double)b.size();
+        if (sa + sb <= 0.0)
+            return ma == mb ? 1.0 : 0.0;
+        double t = (ma - mb) / std::sqrt(sa + sb);
+        double dof = (sa + sb) * (sa + sb) /
+                     (sa * sa / (double)(a.size() - 1) + sb * sb / (double)(b.size() - 1));
+        return incompleteBeta(dof / 2.0, 0.5, dof / (dof + t * t));
+    }
+}
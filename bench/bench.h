@@ -0,0 +1,383 @@
+// Minimal self-contained benchmark harness: auto-calibrated batches,
+// repeated samples, mean ns/op with a 95% confidence interval, JSON output
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <unistd.h>
+
+#include "baseline.h"
+#include "perf_counters.h"
+
+namespace bench
+{
+    // Keep a value (and the work that produced it) alive
+    template <typename T>
+    inline void doNotOptimize(const T &v)
+    {
+        asm volatile("" : : "g"(&v) : "memory");
+    }
+
+    inline uint64_t nowNs()
+    {
+        return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+
+    // Two-sided 95% Student t quantile for n-1 degrees of freedom
+    inline double t95(int dof)
+    {
+        static const double table[] = {0, 12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262,
+                                       2.228, 2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093,
+                                       2.086, 2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042};
+        if (dof <= 0)
+            return 0.0;
+        if (dof <= 30)
+            return table[dof];
+        return 1.96;
+    }
+
+    struct Param
+    {
+        std::string key;
+        std::string value; // already JSON-encoded (number or quoted string)
+    };
+
+    struct Result
+    {
+        std::string name;
+        std::vector<Param> params;
+        std::vector<double> samples; // ns/op per sample
+        uint64_t opsPerSample{0};
+        // Extra per-operation figures reported next to the timing
+        std::vector<std::pair<std::string, double>> metrics;
+        double mean{0}, stddev{0}, median{0}, ciLow{0}, ciHigh{0};
+
+        std::string id() const
+        {
+            std::string s = name;
+            for (const Param &p : params)
+                s += "/" + p.key + "=" + p.value;
+            s.erase(std::remove(s.begin(), s.end(), '"'), s.end());
+            return s;
+        }
+    };
+
+    struct Options
+    {
+        int samples{10};
+        double minSampleMs{5.0};  // calibrate batches to at least this long
+        double maxBenchMs{1500.0}; // stop sampling a benchmark after this
+        std::string filter;
+        std::string jsonPath; // "" = stdout
+        bool quiet{false};
+        bool perf{false}; // hardware counters per op (perf_event_open)
+        std::string saveBaseline;  // write samples here after the run
+        std::string compareWith;   // baseline to test this run against
+        double thresholdPct{5.0};  // slowdown that counts as a regression
+        double alpha{0.05};        // significance level for the t-test
+    };
+
+    inline std::string num(double v)
+    {
+        char b[32];
+        std::snprintf(b, sizeof b, "%.15g", v);
+        return b;
+    }
+    inline std::string str(const std::string &v) { return "\"" + v + "\""; }
+
+    class Harness
+    {
+    public:
+        // Parses --samples N --min-sample-ms X --max-bench-ms X --filter S
+        // --json FILE --quiet --perf --save-baseline FILE --compare FILE
+        // --threshold PCT --alpha P; unknown arguments are returned for the
+        // caller
+        std::vector<std::string> parse(int argc, char **argv)
+        {
+            std::vector<std::string> rest;
+            for (int i = 1; i < argc; ++i)
+            {
+                std::string a = argv[i];
+                bool more = i + 1 < argc;
+                if (a == "--samples" && more)
+                    opt.samples = std::max(2, std::atoi(argv[++i]));
+                else if (a == "--min-sample-ms" && more)
+                    opt.minSampleMs = std::atof(argv[++i]);
+                else if (a == "--max-bench-ms" && more)
+                    opt.maxBenchMs = std::atof(argv[++i]);
+                else if (a == "--filter" && more)
+                    opt.filter = argv[++i];
+                else if (a == "--json" && more)
+                    opt.jsonPath = argv[++i];
+                else if (a == "--quiet")
+                    opt.quiet = true;
+                else if (a == "--perf")
+                    opt.perf = true;
+                else if (a == "--save-baseline" && more)
+                    opt.saveBaseline = argv[++i];
+                else if (a == "--compare" && more)
+                    opt.compareWith = argv[++i];
+                else if (a == "--threshold" && more)
+                    opt.thresholdPct = std::atof(argv[++i]);
+                else if (a == "--alpha" && more)
+                    opt.alpha = std::atof(argv[++i]);
+                else
+                    rest.push_back(a);
+            }
+            if (opt.perf && counters.open() == 0)
+            {
+                std::fprintf(stderr, "note: perf_event_open unavailable (check kernel.perf_event_paranoid); "
+                                     "reporting timings only\n");
+                opt.perf = false;
+            }
+            return rest;
+        }
+
+        bool selected(const std::string &id) const
+        {
+            return opt.filter.empty() || id.find(opt.filter) != std::string::npos;
+        }
+
+        // body(iters) performs iters operations. Returns the stored result
+        // (to attach metrics; valid until the next run()) or nullptr if the
+        // filter skipped it.
+        template <typename Body>
+        Result *run(const std::string &name, std::vector<Param> params, Body &&body)
+        {
+            Result r;
+            r.name = name;
+            r.params = std::move(params);
+            if (!selected(r.id()))
+                return nullptr;
+
+            // Calibrate: double the batch until it takes minSampleMs
+            uint64_t iters = 1;
+            const double minNs = opt.minSampleMs * 1e6;
+            while (true)
+            {
+                uint64_t t0 = nowNs();
+                body(iters);
+                uint64_t dt = nowNs() - t0;
+                if ((double)dt >= minNs || iters >= (1ull << 40))
+                    break;
+                uint64_t grow = dt > 0 ? (uint64_t)(minNs / (double)dt * (double)iters * 1.2) : iters * 16;
+                iters = std::max(iters * 2, std::min(grow, iters * 16));
+            }
+            r.opsPerSample = iters;
+
+            const double budget = opt.maxBenchMs * 1e6;
+            uint64_t start = nowNs();
+            counters.clearTotals();
+            for (int s = 0; s < opt.samples; ++s)
+            {
+                if (opt.perf)
+                    counters.start();
+                uint64_t t0 = nowNs();
+                body(iters);
+                uint64_t dt = nowNs() - t0;
+                if (opt.perf)
+                    counters.stop();
+                r.samples.push_back((double)dt / (double)iters);
+                if (s >= 2 && (double)(nowNs() - start) > budget)
+                    break;
+            }
+            summarize(r);
+            if (!opt.quiet)
+                std::fprintf(stderr, "%-58s %12.2f ns/op  ±%5.1f%%  (n=%zu x %llu)\n", r.id().c_str(), r.mean,
+                             r.mean > 0 ? 100.0 * (r.ciHigh - r.mean) / r.mean : 0.0, r.samples.size(),
+                             (unsigned long long)r.opsPerSample);
+            results.push_back(std::move(r));
+            Result *stored = &results.back();
+            if (opt.perf)
+            {
+                double ops = (double)stored->opsPerSample * (double)stored->samples.size();
+                double cycles = 0, instructions = 0;
+                for (const PerfCounters::Reading &c : counters.totals())
+                {
+                    addMetric(stored, c.name + "_per_op", c.value / ops);
+                    if (c.name == "cycles")
+                        cycles = c.value;
+                    else if (c.name == "instructions")
+                        instructions = c.value;
+                }
+                if (cycles > 0 && instructions > 0)
+                    addMetric(stored, "ipc", instructions / cycles);
+            }
+            return stored;
+        }
+
+        void addMetric(Result *r, const std::string &key, double value) const
+        {
+            if (!r)
+                return;
+            r->metrics.emplace_back(key, value);
+            if (!opt.quiet)
+                std::fprintf(stderr, "%58s %14.2f %s\n", "", value, key.c_str());
+        }
+
+        static void summarize(Result &r)
+        {
+            size_t n = r.samples.size();
+            double sum = 0;
+            for (double v : r.samples)
+                sum += v;
+            r.mean = sum / (double)n;
+            double ss = 0;
+            for (double v : r.samples)
+                ss += (v - r.mean) * (v - r.mean);
+            r.stddev = n > 1 ? std::sqrt(ss / (double)(n - 1)) : 0.0;
+            std::vector<double> sorted = r.samples;
+            std::sort(sorted.begin(), sorted.end());
+            r.median = n % 2 ? sorted[n / 2] : 0.5 * (sorted[n / 2 - 1] + sorted[n / 2]);
+            double half = t95((int)n - 1) * r.stddev / std::sqrt((double)n);
+            r.ciLow = r.mean - half;
+            r.ciHigh = r.mean + half;
+        }
+
+        std::string json(const std::string &suite) const
+        {
+            char host[256] = "unknown";
+            gethostname(host, sizeof host - 1);
+            std::string out = "{\n  \"schema\": 1,\n  \"suite\": " + str(suite) +
+                              ",\n  \"host\": " + str(host) +
+                              ",\n  \"timestamp\": " + num((double)std::time(nullptr)) +
+                              ",\n  \"benchmarks\": [";
+            for (size_t i = 0; i < results.size(); ++i)
+            {
+                const Result &r = results[i];
+                out += i ? ",\n    {" : "\n    {";
+                out += "\"id\": " + str(r.id()) + ", \"name\": " + str(r.name);
+                for (const Param &p : r.params)
+                    out += ", " + str(p.key) + ": " + p.value;
+                out += ", \"ns_per_op\": " + num(r.mean) +
+                       ", \"ci95_low\": " + num(r.ciLow) +
+                       ", \"ci95_high\": " + num(r.ciHigh) +
+                       ", \"median\": " + num(r.median) +
+                       ", \"stddev\": " + num(r.stddev) +
+                       ", \"ops_per_sample\": " + num((double)r.opsPerSample);
+                for (const auto &m : r.metrics)
+                    out += ", " + str(m.first) + ": " + num(m.second);
+                out += ", \"samples\": [";
+                for (size_t s = 0; s < r.samples.size(); ++s)
+                    out += (s ? ", " : "") + num(r.samples[s]);
+                out += "]}";
+            }
+            out += "\n  ]\n}\n";
+            return out;
+        }
+
+        // Write JSON to --json FILE or stdout, then save / compare baselines.
+        // Returns the process exit status: 0 ok, 1 I/O error, 3 regression.
+        int finish(const std::string &suite) const
+        {
+            std::string j = json(suite);
+            FILE *f = opt.jsonPath.empty() ? stdout : std::fopen(opt.jsonPath.c_str(), "w");
+            if (!f)
+                return 1;
+            bool ok = std::fwrite(j.data(), 1, j.size(), f) == j.size();
+            if (f != stdout)
+                ok = (std::fclose(f) == 0) && ok;
+            if (!ok)
+                return 1;
+            if (!opt.compareWith.empty())
+            {
+                int rc = compare(suite);
+                if (rc != 0)
+                    return rc;
+            }
+            if (!opt.saveBaseline.empty() && !save(suite))
+                return 1;
+            return 0;
+        }
+
+        bool save(const std::string &suite) const
+        {
+            std::ofstream out(opt.saveBaseline, std::ios::trunc);
+            if (!out.good())
+            {
+                std::fprintf(stderr, "cannot write baseline %s\n", opt.saveBaseline.c_str());
+                return false;
+            }
+            out << "# bytehebi-bench-baseline " << baselineVersion << "\n"
+                << "suite " << suite << "\n"
+                << "commit " << gitCommit() << "\n";
+            for (const Result &r : results)
+            {
+                out << "bench " << r.id();
+                for (double v : r.samples)
+                    out << " " << num(v);
+                out << "\n";
+            }
+            std::fprintf(stderr, "baseline saved to %s (%zu benchmarks)\n", opt.saveBaseline.c_str(), results.size());
+            return out.good();
+        }
+
+        // Prints per-benchmark deltas; 3 if any slowdown is both significant
+        // and above the threshold
+        int compare(const std::string &suite) const
+        {
+            Baseline base;
+            std::string err;
+            if (!loadBaseline(opt.compareWith, base, err))
+            {
+                std::fprintf(stderr, "%s\n", err.c_str());
+                return 1;
+            }
+            if (base.suite != suite)
+                std::fprintf(stderr, "warning: baseline suite '%s' differs from '%s'\n", base.suite.c_str(), suite.c_str());
+            std::fprintf(stderr, "\ncompare against %s (commit %s), threshold %.1f%%, alpha %.3f\n",
+                         opt.compareWith.c_str(), base.commit.c_str(), opt.thresholdPct, opt.alpha);
+            int regressions = 0, improvements = 0, missing = 0;
+            for (const Result &r : results)
+            {
+                auto it = base.samples.find(r.id());
+                if (it == base.samples.end() || it->second.empty())
+                {
+                    ++missing;
+                    std::fprintf(stderr, "  %-58s %12s\n", r.id().c_str(), "new");
+                    continue;
+                }
+                double old = 0;
+                for (double v : it->second)
+                    old += v;
+                old /= (double)it->second.size();
+                double delta = old > 0 ? 100.0 * (r.mean - old) / old : 0.0;
+                double p = welchP(r.samples, it->second);
+                bool significant = p < opt.alpha;
+                const char *verdict = "";
+                if (significant && delta > opt.thresholdPct)
+                {
+                    verdict = "REGRESSION";
+                    ++regressions;
+                }
+                else if (significant && delta < -opt.thresholdPct)
+                {
+                    verdict = "faster";
+                    ++improvements;
+                }
+                else if (!significant)
+                    verdict = "~";
+                std::fprintf(stderr, "  %-58s %+8.2f%%  p=%.4f  %s\n", r.id().c_str(), delta, p, verdict);
+            }
+            std::fprintf(stderr, "%d regression(s), %d improvement(s), %d new\n", regressions, improvements, missing);
+            return regressions ? 3 : 0;
+        }
+
+        Options opt;
+        std::vector<Result> results;
+
+    private:
+        PerfCounters counters;
+    };
+}
@@ -0,0 +1,138 @@
+// Headless render benchmark: Game::render() + notcurses_render() into a
+// pseudo-terminal of fixed size whose output is drained and discarded.
+// Reports µs/frame and bytes emitted per frame over scripted states.
+#include "bench.h"
+#include "game_probe.h"
+#include "pty.h"
+#include <memory>
+
+#include <unistd.h>
+
+#include <notcurses/notcurses.h>
+
+namespace
+{
+    struct Scene
+    {
+        std::string name;
+        double fill;
+        int style;
+        int dialog;
+    };
+}
+
+int main(int argc, char **argv)
+{
+    bench::Harness h;
+    h.opt.maxBenchMs = 1000.0;
+    if (!h.parse(argc, argv).empty())
+    {
+        std::fprintf(stderr, "usage: %s [--samples N] [--min-sample-ms X] [--max-bench-ms X]\n"
+                             "          [--filter S] [--json FILE] [--quiet] [--perf]\n"
+                             "          [--save-baseline FILE | --compare FILE [--threshold PCT] [--alpha P]]\n",
+                     argv[0]);
+        return 2;
+    }
+
+    const int bw = 80, bh = 30;
+    // Terminal widths that make render() pick xscale 2 and 1 for 80x30
+    const struct
+    {
+        int xscale;
+        unsigned rows, cols;
+    } terms[] = {{2, 40, 200}, {1, 40, 120}};
+
+    static const char *dialogs[] = {"none", "pause", "gameover", "entername"};
+    std::vector<Scene> scenes;
+    for (double fill : {0.0, 0.5, 0.9})
+        scenes.push_back({"fill", fill, 1, 0});
+    for (int st = 0; st < GameProbe::styleCount; ++st)
+        scenes.push_back({"style", 0.5, st, 0});
+    for (int d = 1; d <= 3; ++d)
+        scenes.push_back({"dialog", 0.5, 1, d});
+
+    // Keep Notcurses' terminfo lookup stable across machines
+    setenv("TERM", "xterm-256color", 1);
+    const int savedStdin = dup(STDIN_FILENO);
+
+    for (const auto &t : terms)
+    {
+        term::PtySink sink;
+        if (!sink.open(t.rows, t.cols))
+        {
+            std::fprintf(stderr, "cannot open a pseudo-terminal\n");
+            return 1;
+        }
+        // Notcurses may read query replies from stdin; point it at the pty
+        dup2(sink.slaveFd(), STDIN_FILENO);
+        FILE *out = fdopen(dup(sink.slaveFd()), "w");
+        notcurses_options opts{};
+        opts.flags = NCOPTION_SUPPRESS_BANNERS | NCOPTION_NO_QUIT_SIGHANDLERS |
+                     NCOPTION_NO_WINCH_SIGHANDLER | NCOPTION_INHIBIT_SETLOCALE;
+        notcurses *nc = notcurses_init(&opts, out);
+        if (!nc)
+        {
+            std::fprintf(stderr, "notcurses_init failed on the pty sink\n");
+            return 1;
+        }
+
+        auto game = std::make_unique<Game>(bw, bh);
+        game->setLeaderboardFile("");
+        game->setHistoryFile("");
+        game->setSaveFile("");
+        game->setReplayDir("");
+        game->setSeed(99u);
+        game->attachNotcurses(nc);
+
+        for (const Scene &sc : scenes)
+        {
+            size_t len = std::max<size_t>(3, (size_t)(sc.fill * (bw - 2) * (bh - 2)));
+            Snake &s = GameProbe::snake(*game);
+            s = cycleSnake(bw, bh, len);
+            GameProbe::setStyle(*game, sc.style);
+            GameProbe::setDialog(*game, sc.dialog);
+
+            std::vector<bench::Param> params = {
+                {"xscale", bench::num(t.xscale)},
+                {"length", bench::num((double)len)},
+                {"style", bench::str(GameProbe::styleName(sc.style))},
+                {"dialog", bench::str(dialogs[sc.dialog])},
+            };
+            // The snake advances one cell per frame so every frame has a
+            // realistic diff to emit
+            uint64_t renderNs = 0, ncNs = 0, frames = 0;
+            ncstats before{}, after{};
+            notcurses_stats(nc, &before);
+            bench::Result *r = h.run("Game::render+notcurses_render", params, [&](uint64_t n)
+                                     {
+                for (uint64_t i = 0; i < n; ++i)
+                {
+                    s.setDirection(cycleDir(s.head(), bw, bh));
+                    s.move(false);
+                    uint64_t t0 = bench::nowNs();
+                    GameProbe::render(*game);
+                    uint64_t t1 = bench::nowNs();
+                    notcurses_render(nc);
+                    uint64_t t2 = bench::nowNs();
+                    renderNs += t1 - t0;
+                    ncNs += t2 - t1;
+                }
+                frames += n; });
+            notcurses_stats(nc, &after);
+            if (r && frames)
+            {
+                h.addMetric(r, "us_per_frame", r->mean / 1000.0);
+                h.addMetric(r, "render_us_per_frame", (double)renderNs / 1000.0 / (double)frames);
+                h.addMetric(r, "notcurses_render_us_per_frame", (double)ncNs / 1000.0 / (double)frames);
+                h.addMetric(r, "bytes_per_frame", (double)(after.raster_bytes - before.raster_bytes) / (double)frames);
+            }
+        }
+
+        game->attachNotcurses(nullptr);
+        game.reset();
+        notcurses_stop(nc);
+        fclose(out);
+        dup2(savedStdin, STDIN_FILENO);
+    }
+    return h.finish("render");
+}
@@ -0,0 +1,194 @@
+// Microbenchmarks for the simulation primitives: Snake::move, contains,
+// hitsSelf, Fruit::respawn and Game::update across board sizes and fills,
+// Level::step per board, and LevelGenerator::generate per style and board size
+#include "bench.h"
+#include "game_probe.h"
+#include "level_gen.h"
+#include <memory>
+
+namespace
+{
+    struct Board
+    {
+        int w, h;
+    };
+
+    size_t lengthFor(const Board &b, double fill)
+    {
+        size_t cells = (size_t)(b.w - 2) * (size_t)(b.h - 2);
+        return std::max<size_t>(3, (size_t)(fill * (double)cells));
+    }
+
+    std::string dims(const Board &b)
+    {
+        return std::to_string(b.w) + "x" + std::to_string(b.h);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    bench::Harness h;
+    int maxBoard = 4096;
+    for (const std::string &a : h.parse(argc, argv))
+    {
+        if (a.rfind("--max-board=", 0) == 0)
+            maxBoard = std::atoi(a.c_str() + 12);
+        else
+        {
+            std::fprintf(stderr, "usage: %s [--max-board=N] [--samples N] [--min-sample-ms X]\n"
+                                 "          [--max-bench-ms X] [--filter S] [--json FILE] [--quiet] [--perf]\n"
+                                 "          [--save-baseline FILE | --compare FILE [--threshold PCT] [--alpha P]]\n",
+                         argv[0]);
+            return 2;
+        }
+    }
+
+    const Board boards[] = {{80, 30}, {256, 256}, {1024, 1024}, {4096, 4096}};
+    const double fills[] = {0.0, 0.1, 0.5, 0.9, 0.99};
+    using bench::num;
+    using bench::str;
+
+    for (const Board &b : boards)
+    {
+        if (b.w > maxBoard || b.h > maxBoard)
+            continue;
+        for (double fill : fills)
+        {
+            size_t len = lengthFor(b, fill);
+            std::vector<bench::Param> params = {{"board", str(dims(b))}, {"fill", num(fill)}, {"length", num((double)len)}};
+            auto want = [&](const char *name)
+            {
+                bench::Result probe;
+                probe.name = name;
+                probe.params = params;
+                return h.selected(probe.id());
+            };
+            if (!want("Snake::move") && !want("Snake::contains") && !want("Snake::hitsSelf") &&
+                !want("Fruit::respawn") && !want("Game::update"))
+                continue;
+
+            const Snake base = cycleSnake(b.w, b.h, len);
+
+            {
+                Snake s = base;
+                h.run("Snake::move", params, [&](uint64_t n)
+                      {
+                    for (uint64_t i = 0; i < n; ++i)
+                        s.move(false);
+                    bench::doNotOptimize(s.head()); });
+            }
+
+            // Worst case: a miss scans every segment
+            const Point miss{0, 0};
+            h.run("Snake::contains", params, [&](uint64_t n)
+                  {
+                for (uint64_t i = 0; i < n; ++i)
+                {
+                    bool r = base.contains(miss);
+                    bench::doNotOptimize(r);
+                } });
+            h.run("Snake::hitsSelf", params, [&](uint64_t n)
+                  {
+                Point next = base.nextHead();
+                for (uint64_t i = 0; i < n; ++i)
+                {
+                    bool r = base.hitsSelf(next);
+                    bench::doNotOptimize(r);
+                } });
+
+            {
+                Fruit f(b.w, b.h, 1234u);
+                h.run("Fruit::respawn", params, [&](uint64_t n)
+                      {
+                    for (uint64_t i = 0; i < n; ++i)
+                    {
+                        f.respawn([&](const Point &p)
+                                  { return base.contains(p); });
+                        bench::doNotOptimize(f.position());
+                    } });
+            }
+
+            if (want("Game::update"))
+            {
+                auto g = std::make_unique<Game>(b.w, b.h);
+                g->setLeaderboardFile("");
+                g->setHistoryFile("");
+                g->setSaveFile("");
+                g->setReplayDir("");
+                g->setSeed(1234u);
+                Snake &s = GameProbe::snake(*g);
+                s = base;
+                GameProbe::fruit(*g).respawn([&](const Point &p)
+                                             { return s.contains(p); });
+                h.run("Game::update", params, [&](uint64_t n)
+                      {
+                    for (uint64_t i = 0; i < n; ++i)
+                    {
+                        s.setDirection(cycleDir(s.head(), b.w, b.h));
+                        GameProbe::update(*g);
+                        if (GameProbe::over(*g))
+                        {
+                            // Board filled up: start over from the prepared layout
+                            s = base;
+                            GameProbe::over(*g) = false;
+                        }
+                    } });
+            }
+        }
+    }
+    // A head circling the inside of the border, one neighbour-table lookup
+    // per step; boards past Level::kLinkedCells work each step out instead
+    for (const Board &b : boards)
+    {
+        if (b.w > maxBoard || b.h > maxBoard)
+            continue;
+        Level level = Level::rectangle(b.w, b.h);
+        Point head{1, 1};
+        Direction d = Direction::Right;
+        bool table = (size_t)b.w * (size_t)b.h <= Level::kLinkedCells;
+        h.run("Level::step", {{"board", str(dims(b))}, {"table", str(table ? "yes" : "no")}}, [&](uint64_t n)
+              {
+                  for (uint64_t i = 0; i < n; ++i)
+                  {
+                      Point next;
+                      if (!level.step(head, d, next))
+                      {
+                          d = d == Direction::Right ? Direction::Down
+                              : d == Direction::Down ? Direction::Left
+                              : d == Direction::Left ? Direction::Up
+                                                     : Direction::Right;
+                          continue;
+                      }
+                      head = next;
+                  }
+                  bench::doNotOptimize(head);
+              });
+    }
+
+    // A new board per operation, each from the next seed, with the
+    // generator's buffers kept warm as Game keeps them between games
+    for (LevelStyle style : {LevelStyle::Maze, LevelStyle::Rooms, LevelStyle::Blocks})
+        for (const Board &b : {boards[0], boards[1], boards[2]})
+        {
+            if (b.w > maxBoard || b.h > maxBoard)
+                continue;
+            LevelGenerator gen;
+            Level level;
+            uint64_t seed = 0;
+            bench::Result *r = h.run("LevelGenerator::generate",
+                                     {{"style", str(levelStyleName(style))}, {"board", str(dims(b))}},
+                                     [&](uint64_t n)
+                                     {
+                                         for (uint64_t i = 0; i < n; ++i)
+                                             gen.generate(style, b.w, b.h, seed++, level);
+                                         bench::doNotOptimize(level.id());
+                                     });
+            if (r)
+            {
+                h.addMetric(r, "levels_per_s", r->mean > 0 ? 1e9 / r->mean : 0.0);
+                h.addMetric(r, "free_fraction",
+                            (double)LevelGenerator::freeCells(level) / ((double)b.w * (double)b.h));
+            }
+        }
+    return h.finish("sim");
+}
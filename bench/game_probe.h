@@ -0,0 +1,61 @@
+// Access to Game internals for the bench/ harnesses (Game declares
+// GameProbe a friend)
+#pragma once
+#include "game.h"
+
+struct GameProbe
+{
+    static Snake &snake(Game &g) { return g.snake; }
+    static Fruit &fruit(Game &g) { return g.fruit; }
+    static bool &over(Game &g) { return g.over; }
+    static int &score(Game &g) { return g.score; }
+    static void update(Game &g) { g.update(); }
+    static void reset(Game &g) { g.reset(); }
+    static void render(const Game &g) { g.render(); }
+
+    static constexpr int styleCount = 9;
+    static void setStyle(Game &g, int i) { g.snakeStyle = static_cast<Game::SnakeGlyphStyle>(i); }
+    static const char *styleName(int i)
+    {
+        static const char *names[styleCount] = {"Light", "Heavy", "Rounded", "Scales", "DoubleLine",
+                                                "Block", "Arrow", "Dotted", "Braille"};
+        return names[i];
+    }
+
+    // 0 = none, 1 = Pause, 2 = GameOver, 3 = EnterName
+    static void setDialog(Game &g, int d)
+    {
+        if (d == 0)
+            g.closeDialog();
+        else
+            g.openDialog(static_cast<Game::DialogType>(d));
+    }
+};
+
+// Hamiltonian cycle over the playable area (needs an even number of inner
+// rows): column 1 runs up, rows 1..H snake right/left over columns 2..W.
+// A snake following it never hits a wall or itself.
+inline Direction cycleDir(const Point &p, int w, int h)
+{
+    const int W = w - 2, H = h - 2;
+    if (p.x == 1)
+        return p.y == 1 ? Direction::Right : Direction::Up;
+    if (p.y % 2 == 1)
+        return p.x < W ? Direction::Right : Direction::Down;
+    if (p.x > 2)
+        return Direction::Left;
+    return p.y == H ? Direction::Left : Direction::Down;
+}
+
+// Snake of the given length laid along the cycle, head leading
+inline Snake cycleSnake(int w, int h, size_t length)
+{
+    Snake s(1, 1, 1, (size_t)w * (size_t)h);
+    while (s.segments().size() < length)
+    {
+        s.setDirection(cycleDir(s.head(), w, h));
+        s.move(true);
+    }
+    s.setDirection(cycleDir(s.head(), w, h));
+    return s;
+}
@@ -0,0 +1,303 @@
+// End-to-end input latency: runs the real snake binary on a pseudo-terminal,
+// injects arrow keys at known times and watches the escape stream for the
+// turned head glyph. Reports the key-to-glyph latency distribution and the
+// terminal bytes written per second.
+#include "frame_stats.h"
+#include "pty.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include <climits>
+#include <csignal>
+#include <ftw.h>
+#include <poll.h>
+#include <sys/wait.h>
+
+namespace
+{
+    uint64_t nowNs()
+    {
+        return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+
+    // Turning clockwise keeps the snake circling a small square, and every
+    // key changes the head glyph: Up, Left, Down, Right, Up, ...
+    struct Turn
+    {
+        const char *key;   // bytes sent to the tty
+        const char *glyph; // head glyph expected once the turn is drawn
+    };
+    const Turn turns[] = {
+        {"\x1b[A", "▲"},
+        {"\x1b[D", "◀"},
+        {"\x1b[B", "▼"},
+        {"\x1b[C", "▶"},
+    };
+
+    // mkdtemp directory the game runs in, removed with whatever the game
+    // left there (save, leaderboard, history, replays) when it goes out of
+    // scope, so every return path cleans up
+    class ScratchDir
+    {
+    public:
+        bool create()
+        {
+            std::strcpy(path, "/tmp/snake-latency-XXXXXX");
+            made = mkdtemp(path) != nullptr;
+            return made;
+        }
+        ~ScratchDir()
+        {
+            if (made)
+                nftw(path, [](const char *p, const struct stat *, int, struct FTW *)
+                     { return std::remove(p); }, 16, FTW_DEPTH | FTW_PHYS);
+        }
+        const char *c_str() const { return path; }
+
+    private:
+        char path[32];
+        bool made{false};
+    };
+
+    // Ctrl-C ends the run early; the results so far are still printed and
+    // the scratch directory removed
+    volatile sig_atomic_t g_interrupted = 0;
+
+    class Session
+    {
+    public:
+        ~Session() { stop(); }
+
+        bool start(const char *bin, unsigned rows, unsigned cols, const char *workdir)
+        {
+            if (!pty.open(rows, cols))
+                return false;
+            child = fork();
+            if (child < 0)
+                return false;
+            if (child == 0)
+            {
+                setsid();
+                ioctl(pty.slave, TIOCSCTTY, 0);
+                dup2(pty.slave, STDIN_FILENO);
+                dup2(pty.slave, STDOUT_FILENO);
+                dup2(pty.slave, STDERR_FILENO);
+                ::close(pty.master);
+                if (workdir && chdir(workdir) != 0)
+                    _exit(127);
+                setenv("TERM", "xterm-256color", 1);
+                execl(bin, bin, "--flight", "", (char *)nullptr);
+                _exit(127);
+            }
+            ::close(pty.slave);
+            pty.slave = -1;
+            return true;
+        }
+
+        void stop()
+        {
+            if (child > 0)
+            {
+                send("q");
+                // Give it a moment to restore the terminal, then make sure
+                for (int i = 0; i < 50 && waitpid(child, nullptr, WNOHANG) == 0; ++i)
+                    pump(20);
+                if (waitpid(child, nullptr, WNOHANG) == 0)
+                {
+                    kill(child, SIGTERM);
+                    waitpid(child, nullptr, 0);
+                }
+                child = -1;
+            }
+            pty.close();
+        }
+
+        void send(const char *s)
+        {
+            ssize_t w = write(pty.master, s, std::strlen(s));
+            (void)w;
+        }
+
+        // Read whatever arrives within timeoutMs; appends to `recent` (the
+        // stream since the last mark()) and returns false if the child exited
+        bool pump(int timeoutMs)
+        {
+            struct pollfd pfd{pty.master, POLLIN, 0};
+            if (poll(&pfd, 1, timeoutMs) <= 0)
+                return true;
+            char buf[1 << 16];
+            ssize_t n = read(pty.master, buf, sizeof buf);
+            if (n <= 0)
+                return false;
+            lastRead = nowNs();
+            bytes += (uint64_t)n;
+            responder.scan(pty.master, buf, (size_t)n);
+            recent.append(buf, (size_t)n);
+            return true;
+        }
+
+        // Forget the stream so far (keep a few bytes for split glyphs)
+        void mark()
+        {
+            if (recent.size() > 8)
+                recent.erase(0, recent.size() - 8);
+        }
+
+        // Pump until `needle` shows up or timeoutMs passes; returns the read
+        // timestamp of the chunk that completed it, 0 on timeout
+        uint64_t waitFor(const char *needle, int timeoutMs)
+        {
+            uint64_t deadline = nowNs() + (uint64_t)timeoutMs * 1000000ull;
+            while (nowNs() < deadline)
+            {
+                if (recent.find(needle) != std::string::npos)
+                    return lastRead;
+                if (!pump(5))
+                    return 0;
+            }
+            return recent.find(needle) != std::string::npos ? lastRead : 0;
+        }
+
+        std::string recent;
+        uint64_t bytes{0};
+
+    private:
+        term::Pty pty;
+        term::QueryResponder responder;
+        pid_t child{-1};
+        uint64_t lastRead{0};
+    };
+
+    void usage(const char *argv0)
+    {
+        std::fprintf(stderr, "usage: %s [--bin PATH] [--turns N] [--interval MS] [--rows R] [--cols C]\n"
+                             "  --bin PATH     snake binary (default ./snake)\n"
+                             "  --turns N      arrow keys to inject (default 200)\n"
+                             "  --interval MS  pause between keys (default 400)\n"
+                             "  --rows/--cols  terminal size (default 40x200)\n",
+                     argv0);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    std::string bin = "./snake";
+    int turnCount = 200;
+    int intervalMs = 400;
+    unsigned rows = 40, cols = 200;
+    for (int i = 1; i < argc; ++i)
+    {
+        bool more = i + 1 < argc;
+        if (std::strcmp(argv[i], "--bin") == 0 && more)
+            bin = argv[++i];
+        else if (std::strcmp(argv[i], "--turns") == 0 && more)
+            turnCount = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--interval") == 0 && more)
+            intervalMs = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--rows") == 0 && more)
+            rows = (unsigned)std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--cols") == 0 && more)
+            cols = (unsigned)std::atoi(argv[++i]);
+        else
+        {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    // Run the game in a scratch directory so its high score file and
+    // recorder don't touch the working tree
+    char resolved[PATH_MAX];
+    if (!realpath(bin.c_str(), resolved))
+    {
+        std::fprintf(stderr, "cannot find %s\n", bin.c_str());
+        return 1;
+    }
+    // Declared before the session so the game has exited before it goes
+    ScratchDir scratch;
+    if (!scratch.create())
+    {
+        std::fprintf(stderr, "cannot create scratch directory\n");
+        return 1;
+    }
+    std::signal(SIGINT, [](int)
+                { g_interrupted = 1; });
+    std::signal(SIGTERM, [](int)
+                { g_interrupted = 1; });
+
+    Session s;
+    if (!s.start(resolved, rows, cols, scratch.c_str()))
+    {
+        std::fprintf(stderr, "cannot start %s on a pty\n", resolved);
+        return 1;
+    }
+    if (!s.waitFor("Enter", 5000))
+    {
+        std::fprintf(stderr, "no name dialog within 5 s (terminal too small or startup failed)\n");
+        s.stop();
+        return 1;
+    }
+    s.send("\r"); // accept the default name
+    s.mark();
+    if (!s.waitFor("▶", 2000))
+    {
+        std::fprintf(stderr, "game did not start\n");
+        s.stop();
+        return 1;
+    }
+
+    LatencyHistogram hist;
+    int missed = 0, restarts = 0;
+    int next = 0; // index into turns; the snake starts heading right
+    uint64_t streamStart = nowNs();
+    uint64_t bytesStart = s.bytes;
+    for (int i = 0; i < turnCount && !g_interrupted; ++i)
+    {
+        // Let the previous turn settle
+        uint64_t until = nowNs() + (uint64_t)intervalMs * 1000000ull;
+        while (nowNs() < until)
+            s.pump(5);
+        if (s.recent.find("Game Over") != std::string::npos)
+        {
+            // Restart and begin the clockwise pattern again
+            ++restarts;
+            s.send("\r");
+            s.mark();
+            s.waitFor("▶", 2000);
+            next = 0;
+            continue;
+        }
+
+        const Turn &t = turns[next];
+        s.mark();
+        uint64_t sent = nowNs();
+        s.send(t.key);
+        uint64_t seen = s.waitFor(t.glyph, 2000);
+        if (seen == 0)
+        {
+            ++missed;
+            continue;
+        }
+        hist.record(seen - sent);
+        next = (next + 1) % 4;
+    }
+    double seconds = (double)(nowNs() - streamStart) / 1e9;
+    uint64_t bytes = s.bytes - bytesStart;
+    s.stop();
+
+    auto ms = [](uint64_t ns)
+    { return (double)ns / 1e6; };
+    std::printf("input-to-screen latency over %llu turns (%d missed, %d restarts)\n",
+                (unsigned long long)hist.count(), missed, restarts);
+    std::printf("  min %.2f ms  p50 %.2f ms  p90 %.2f ms  p99 %.2f ms  max %.2f ms  mean %.2f ms\n",
+                ms(hist.percentile(0.0)), ms(hist.percentile(0.50)), ms(hist.percentile(0.90)),
+                ms(hist.percentile(0.99)), ms(hist.max()), hist.mean() / 1e6);
+    std::printf("terminal output: %.0f bytes/s (%llu bytes in %.1f s, %ux%u tty)\n",
+                seconds > 0 ? (double)bytes / seconds : 0.0, (unsigned long long)bytes, seconds, cols, rows);
+    return hist.count() ? 0 : 1;
+}
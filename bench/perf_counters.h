@@ -0,0 +1,122 @@
+// Hardware performance counters for benchmark regions via perf_event_open.
+// Every event is optional: whatever the kernel/VM refuses is left out, and
+// if nothing opens the harness just reports timings.
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace bench
+{
+    class PerfCounters
+    {
+    public:
+        struct Reading
+        {
+            std::string name;
+            double value; // scaled for multiplexing
+        };
+
+        ~PerfCounters() { close(); }
+
+        // Returns the number of events opened (0 = unavailable)
+        size_t open()
+        {
+            close();
+            struct Spec
+            {
+                const char *name;
+                uint32_t type;
+                uint64_t config;
+            };
+            const uint64_t l1dMiss = PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                     (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+            const Spec specs[] = {
+                {"cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+                {"instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+                {"l1d_misses", PERF_TYPE_HW_CACHE, l1dMiss},
+                {"llc_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+                {"branch_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+            };
+            for (const Spec &s : specs)
+            {
+                // Separate (non-grouped) events: one unsupported counter must
+                // not take the others down with it
+                struct perf_event_attr attr;
+                std::memset(&attr, 0, sizeof attr);
+                attr.size = sizeof attr;
+                attr.type = s.type;
+                attr.config = s.config;
+                attr.disabled = 1;
+                attr.exclude_kernel = 1;
+                attr.exclude_hv = 1;
+                attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+                int fd = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+                if (fd >= 0)
+                    events.push_back({s.name, fd, 0.0});
+            }
+            return events.size();
+        }
+
+        void close()
+        {
+            for (Event &e : events)
+                ::close(e.fd);
+            events.clear();
+        }
+
+        bool available() const { return !events.empty(); }
+
+        void start()
+        {
+            for (Event &e : events)
+            {
+                ioctl(e.fd, PERF_EVENT_IOC_RESET, 0);
+                ioctl(e.fd, PERF_EVENT_IOC_ENABLE, 0);
+            }
+        }
+
+        // Stop and add this region's counts to the running totals
+        void stop()
+        {
+            for (Event &e : events)
+                ioctl(e.fd, PERF_EVENT_IOC_DISABLE, 0);
+            for (Event &e : events)
+            {
+                uint64_t v[3] = {0, 0, 0}; // value, time enabled, time running
+                if (read(e.fd, v, sizeof v) != (ssize_t)sizeof v || v[2] == 0)
+                    continue;
+                e.total += (double)v[0] * ((double)v[1] / (double)v[2]);
+            }
+        }
+
+        void clearTotals()
+        {
+            for (Event &e : events)
+                e.total = 0.0;
+        }
+
+        std::vector<Reading> totals() const
+        {
+            std::vector<Reading> out;
+            for (const Event &e : events)
+                out.push_back({e.name, e.total});
+            return out;
+        }
+
+    private:
+        struct Event
+        {
+            const char *name;
+            int fd;
+            double total;
+        };
+        std::vector<Event> events;
+    };
+}
@@ -0,0 +1,223 @@
+// Soak test: plays a very long run through Game::update/Game::reset with an
+// automated driver and fails if memory grows or tick latency drifts.
+#include "frame_stats.h"
+#include "game_probe.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+
+#include <malloc.h>
+#include <unistd.h>
+
+namespace
+{
+    uint64_t nowNs()
+    {
+        return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+
+    uint64_t rssKb()
+    {
+        FILE *f = std::fopen("/proc/self/statm", "r");
+        if (!f)
+            return 0;
+        unsigned long size = 0, resident = 0;
+        int n = std::fscanf(f, "%lu %lu", &size, &resident);
+        std::fclose(f);
+        return n == 2 ? (uint64_t)resident * (uint64_t)sysconf(_SC_PAGESIZE) / 1024 : 0;
+    }
+
+    // Bytes handed out by malloc and still in use
+    uint64_t heapInUseKb()
+    {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+        struct mallinfo2 mi = mallinfo2();
+        return (uint64_t)(mi.uordblks + mi.hblkhd) / 1024;
+#else
+        return 0;
+#endif
+    }
+
+    struct Options
+    {
+        uint64_t ticks{1000000000ull};
+        uint64_t window{20000000ull}; // ticks per sample
+        int warmupWindows{3};
+        double seconds{0};            // wall-clock cap, 0 = none
+        double chaos{0.0005};         // chance per tick of a random turn
+        int recreateEvery{5};         // windows between fresh Game objects
+        uint64_t maxRssGrowthKb{2048};
+        uint64_t maxHeapGrowthKb{512};
+        double maxP99Drift{0.5}; // fraction above the warm-up p99
+        int width{80}, height{30};
+        unsigned seed{1};
+    };
+
+    void usage(const char *argv0)
+    {
+        std::fprintf(stderr,
+                     "usage: %s [--ticks N] [--window N] [--warmup W] [--seconds S] [--chaos P]\n"
+                     "          [--recreate-every W] [--max-rss-growth-kb K] [--max-heap-growth-kb K]\n"
+                     "          [--max-p99-drift F] [--board WxH] [--seed N]\n",
+                     argv0);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    Options o;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string a = argv[i];
+        bool more = i + 1 < argc;
+        if (a == "--ticks" && more)
+            o.ticks = (uint64_t)std::strtod(argv[++i], nullptr);
+        else if (a == "--window" && more)
+            o.window = (uint64_t)std::strtod(argv[++i], nullptr);
+        else if (a == "--warmup" && more)
+            o.warmupWindows = std::atoi(argv[++i]);
+        else if (a == "--seconds" && more)
+            o.seconds = std::atof(argv[++i]);
+        else if (a == "--chaos" && more)
+            o.chaos = std::atof(argv[++i]);
+        else if (a == "--recreate-every" && more)
+            o.recreateEvery = std::atoi(argv[++i]);
+        else if (a == "--max-rss-growth-kb" && more)
+            o.maxRssGrowthKb = std::strtoull(argv[++i], nullptr, 0);
+        else if (a == "--max-heap-growth-kb" && more)
+            o.maxHeapGrowthKb = std::strtoull(argv[++i], nullptr, 0);
+        else if (a == "--max-p99-drift" && more)
+            o.maxP99Drift = std::atof(argv[++i]);
+        else if (a == "--board" && more)
+        {
+            if (std::sscanf(argv[++i], "%dx%d", &o.width, &o.height) != 2 || (o.height - 2) % 2 != 0)
+            {
+                std::fprintf(stderr, "--board needs WxH with an even number of inner rows\n");
+                return 2;
+            }
+        }
+        else if (a == "--seed" && more)
+            o.seed = (unsigned)std::strtoul(argv[++i], nullptr, 0);
+        else
+        {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (o.window == 0 || o.warmupWindows < 1)
+    {
+        usage(argv[0]);
+        return 2;
+    }
+
+    // Rank scores in a scratch leaderboard so recreating Game exercises the
+    // submit-at-exit path without touching the real one
+    char scoreFile[] = "/tmp/snake-soak-XXXXXX";
+    int fd = mkstemp(scoreFile);
+    if (fd >= 0)
+        close(fd);
+
+    std::mt19937 rng(o.seed);
+    std::uniform_real_distribution<double> coin(0.0, 1.0);
+    const Direction dirs[] = {Direction::Up, Direction::Down, Direction::Left, Direction::Right};
+    auto makeGame = [&]
+    {
+        auto g = std::make_unique<Game>(o.width, o.height);
+        g->setLeaderboardFile(scoreFile);
+        g->setHistoryFile("");
+        g->setSaveFile("");
+        g->setReplayDir("");
+        g->setSeed(rng());
+        return g;
+    };
+    std::unique_ptr<Game> game = makeGame();
+
+    std::printf("%8s %14s %9s %10s %10s %10s %10s %12s\n", "window", "ticks", "games", "rss_kb", "heap_kb",
+                "p50_us", "p99_us", "ticks/s");
+    uint64_t baseRss = 0, baseHeap = 0, baseP99 = 0;
+    uint64_t done = 0, games = 0;
+    int window = 0;
+    bool failed = false;
+    const uint64_t started = nowNs();
+    LatencyHistogram hist;
+    while (done < o.ticks && !failed)
+    {
+        hist.clear();
+        uint64_t windowStart = nowNs();
+        uint64_t n = std::min(o.window, o.ticks - done);
+        for (uint64_t i = 0; i < n; ++i)
+        {
+            Snake &s = GameProbe::snake(*game);
+            if (o.chaos > 0 && coin(rng) < o.chaos)
+                s.setDirection(dirs[rng() % 4]);
+            else
+                s.setDirection(cycleDir(s.head(), o.width, o.height));
+            uint64_t t0 = nowNs();
+            GameProbe::update(*game);
+            hist.record(nowNs() - t0);
+            if (GameProbe::over(*game))
+            {
+                GameProbe::reset(*game);
+                ++games;
+            }
+        }
+        done += n;
+        ++window;
+        if (o.recreateEvery > 0 && window % o.recreateEvery == 0)
+            game = makeGame();
+
+        uint64_t rss = rssKb(), heap = heapInUseKb();
+        uint64_t p50 = hist.percentile(0.50), p99 = hist.percentile(0.99);
+        double rate = (double)n * 1e9 / (double)(nowNs() - windowStart);
+        std::printf("%8d %14llu %9llu %10llu %10llu %10.2f %10.2f %12.0f\n", window, (unsigned long long)done,
+                    (unsigned long long)games, (unsigned long long)rss, (unsigned long long)heap, p50 / 1e3,
+                    p99 / 1e3, rate);
+        std::fflush(stdout);
+
+        // Warm-up windows set the reference: the highest memory and p99 seen
+        if (window <= o.warmupWindows)
+        {
+            baseRss = std::max(baseRss, rss);
+            baseHeap = std::max(baseHeap, heap);
+            baseP99 = std::max(baseP99, p99);
+        }
+        else
+        {
+            if (rss > baseRss + o.maxRssGrowthKb)
+            {
+                std::printf("FAIL: RSS grew %llu KB over warm-up (limit %llu KB)\n",
+                            (unsigned long long)(rss - baseRss), (unsigned long long)o.maxRssGrowthKb);
+                failed = true;
+            }
+            if (heap > baseHeap + o.maxHeapGrowthKb)
+            {
+                std::printf("FAIL: heap in use grew %llu KB over warm-up (limit %llu KB)\n",
+                            (unsigned long long)(heap - baseHeap), (unsigned long long)o.maxHeapGrowthKb);
+                failed = true;
+            }
+            if ((double)p99 > (double)baseP99 * (1.0 + o.maxP99Drift))
+            {
+                std::printf("FAIL: p99 tick latency %.2f us drifted above warm-up %.2f us (+%.0f%% allowed)\n",
+                            p99 / 1e3, baseP99 / 1e3, o.maxP99Drift * 100.0);
+                failed = true;
+            }
+        }
+        if (o.seconds > 0 && (double)(nowNs() - started) / 1e9 >= o.seconds)
+            break;
+    }
+    game.reset();
+    std::remove(scoreFile);
+
+    if (failed)
+        return 1;
+    std::printf("OK: %llu ticks, %llu games, memory and p99 stable\n", (unsigned long long)done,
+                (unsigned long long)games);
+    return 0;
+}
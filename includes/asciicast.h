@@ -0,0 +1,84 @@
+// Asciicast v2 recording of exactly what Notcurses writes to the terminal
+#pragma once
+#include "pty.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Notcurses draws into a stream we own (a pipe when live, a pseudo-terminal
+// offscreen). A relay thread reads it back, forwards it to the terminal when
+// there is one, and cuts it into events at the frame marks the game loop
+// drops into the same stream after each notcurses_render, so every event is
+// one whole frame stamped with the game's clock. A second thread formats and
+// writes the file; the relay only copies into a fixed buffer, and drops a
+// frame from the cast rather than wait on the disk.
+class AsciicastRecorder
+{
+public:
+    AsciicastRecorder() = default;
+    ~AsciicastRecorder() { close(); }
+    AsciicastRecorder(const AsciicastRecorder &) = delete;
+    AsciicastRecorder &operator=(const AsciicastRecorder &) = delete;
+
+    // Create the file and write the header for a cols x rows terminal
+    bool open(const std::string &path, unsigned cols, unsigned rows);
+    bool isOpen() const { return out != nullptr; }
+
+    // Live: a stream for notcurses_init whose bytes reach terminalFd
+    // unchanged and are recorded on the way
+    FILE *tee(int terminalFd);
+    // Offline: a cols x rows pseudo-terminal to draw into that nobody sees.
+    // Points stdin at it for Notcurses' startup queries until close().
+    FILE *offscreen();
+
+    // After notcurses_render: what has been written since the previous
+    // mark is one event at timeNs (any origin; the first mark is 0)
+    void frame(uint64_t timeNs);
+
+    // After notcurses_stop: drain the stream, finish the file
+    void close();
+
+    // Bytes of output left out of the cast because the writer fell behind
+    uint64_t droppedBytes() const { return dropped.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr size_t bufferBytes = 8u << 20;
+
+    void relayLoop();
+    void scan(const char *p, size_t n);
+    void cut(uint64_t timeNs);
+    void writerLoop();
+
+    FILE *out{nullptr};
+    unsigned cols{0}, rows{0};
+
+    // Stream Notcurses writes; the relay reads the other end
+    FILE *stream{nullptr};
+    int streamFd{-1};
+    int readFd{-1};
+    int terminalFd{-1};
+    term::Pty pty;
+    term::QueryResponder responder;
+    int savedStdin{-1};
+    std::thread relay;
+
+    // Relay-side state: the frame being collected and the mark parser
+    std::vector<char> pending;
+    std::string markTail;
+    bool haveOrigin{false};
+    uint64_t origin{0};
+    uint64_t lastMark{0};
+
+    // Handoff to the writer: events as [uint64 time][uint32 size][bytes]
+    std::thread writer;
+    std::mutex mu;
+    std::condition_variable cv;
+    std::vector<char> queue;
+    bool stopping{false};
+    std::atomic<uint64_t> dropped{0};
+};
@@ -0,0 +1,37 @@
+// Time sources for the game loop
+#pragma once
+#include <chrono>
+#include <thread>
+
+// The loop only asks for "now" and "sleep"; swapping the implementation lets
+// whole sessions run faster than real time.
+class Clock
+{
+public:
+    using duration = std::chrono::nanoseconds;
+    using time_point = std::chrono::time_point<std::chrono::steady_clock, duration>;
+
+    virtual ~Clock() = default;
+    virtual time_point now() const = 0;
+    virtual void sleepFor(duration d) = 0;
+};
+
+// Wall clock: std::chrono::steady_clock + std::this_thread::sleep_for
+class SteadyClock : public Clock
+{
+public:
+    time_point now() const override { return std::chrono::steady_clock::now(); }
+    void sleepFor(duration d) override { std::this_thread::sleep_for(d); }
+};
+
+// Simulated clock: sleeping advances time instantly, nothing ever blocks
+class VirtualClock : public Clock
+{
+public:
+    time_point now() const override { return t; }
+    void sleepFor(duration d) override { t += d; }
+    void advance(duration d) { t += d; }
+
+private:
+    time_point t{};
+};
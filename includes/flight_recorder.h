@@ -0,0 +1,87 @@
+// Always-on flight recorder: the last N ticks in a memory-mapped ring
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+// One tick. Fixed 32 bytes so the ring is a flat array in the file.
+struct FlightRecord
+{
+    uint64_t tick;
+    uint64_t timeNs;  // game clock at the tick
+    uint32_t frameNs; // duration of the previous frame (saturated)
+    uint32_t key;     // last key processed since the previous tick, 0 if none
+    int16_t headX;
+    int16_t headY;
+    uint8_t dir; // Direction
+    uint8_t flags;
+    uint16_t reserved;
+
+    enum : uint8_t
+    {
+        Grew = 1,
+        Died = 2
+    };
+};
+static_assert(sizeof(FlightRecord) == 32, "FlightRecord is an on-disk layout");
+
+// File layout: 64-byte header, then capacity records. The mapping is
+// MAP_SHARED, so the kernel keeps the data even if the process is killed
+// outright; fatal signals additionally msync it.
+class FlightRecorder
+{
+public:
+    FlightRecorder() = default;
+    ~FlightRecorder() { close(); }
+    FlightRecorder(const FlightRecorder &) = delete;
+    FlightRecorder &operator=(const FlightRecorder &) = delete;
+
+    // capacity is rounded up to a power of two. The file stays flock()ed
+    // while open; if another instance holds path, the ring goes to
+    // path.<pid> instead of truncating the other's.
+    bool open(const std::string &path, uint32_t capacity = 8192);
+    // A path.<pid> ring is deleted here: only a crash needs it kept
+    void close();
+    bool isOpen() const { return slots != nullptr; }
+
+    // Hot path: one 32-byte store and one index store
+    void record(const FlightRecord &r)
+    {
+        if (!slots)
+            return;
+        slots[next & mask] = r;
+        ++next;
+        __atomic_store_n(nextInFile, next, __ATOMIC_RELEASE);
+    }
+
+    // Synchronous flush; async-signal-safe (msync only)
+    void flush() const;
+
+    // Print a recorder file, oldest record first
+    static bool dump(const std::string &path, std::ostream &out);
+
+private:
+    void *base{nullptr};
+    size_t mapSize{0};
+    int lockFd{-1};
+    std::string fallback; // the path.<pid> file in use, if any
+    FlightRecord *slots{nullptr};
+    uint64_t *nextInFile{nullptr};
+    uint64_t next{0};
+    uint64_t mask{0};
+};
+
+// Fatal-signal handling around the Notcurses session: flush the recorder,
+// put the terminal back (cooked mode, main screen, visible cursor) and then
+// defer to whatever handler was installed before.
+namespace crash_guard
+{
+    // Snapshot the terminal's termios; call before notcurses_init()
+    void saveTerminal();
+    // Install handlers for SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT,
+    // SIGTERM, SIGINT, SIGHUP and SIGQUIT. recorder may be null.
+    void install(const FlightRecorder *recorder);
+    // Restore the previous handlers; call before notcurses_stop()
+    void uninstall();
+}
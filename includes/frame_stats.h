@@ -0,0 +1,95 @@
+// Frame timing: HDR-style histograms and a sliding window for the HUD overlay
+#pragma once
+#include <array>
+#include <cstdint>
+#include <ostream>
+
+// Log-linear histogram of nanosecond samples (32 sub-buckets per power of
+// two, ~3% relative precision, values up to ~18 minutes). Fixed size, so
+// recording never allocates.
+class LatencyHistogram
+{
+public:
+    void record(uint64_t ns);
+    void clear();
+
+    uint64_t count() const { return total; }
+    uint64_t max() const { return maxValue; }
+    double mean() const { return total ? (double)sum / (double)total : 0.0; }
+    // Smallest recorded value v such that a fraction q of samples are <= v
+    uint64_t percentile(double q) const;
+
+    // Percentile distribution in the HdrHistogram text layout
+    void dump(std::ostream &out, const char *label) const;
+
+private:
+    static constexpr int subBits = 5;
+    static constexpr int subCount = 1 << subBits;
+    static constexpr int maxShift = 35; // 2^40 ns
+    static constexpr int bucketCount = (maxShift + 2) * subCount;
+
+    static int bucketOf(uint64_t v);
+    static uint64_t bucketHigh(int idx);
+
+    std::array<uint64_t, bucketCount> counts{};
+    uint64_t total{0};
+    uint64_t sum{0};
+    uint64_t maxValue{0};
+};
+
+// Last N samples of one phase, for live p50/p99/max
+class SampleWindow
+{
+public:
+    static constexpr int size = 128;
+
+    void push(uint64_t ns);
+    uint64_t percentile(double q) const;
+    uint64_t max() const;
+    int filled() const { return n; }
+    // i = 0 is the newest sample
+    uint64_t recent(int i) const { return samples[(head - 1 - i + size) % size]; }
+
+private:
+    std::array<uint64_t, size> samples{};
+    int head{0};
+    int n{0};
+};
+
+// Per-phase timings for the game loop
+struct FrameStats
+{
+    enum Phase
+    {
+        Input,
+        Update,
+        Render,
+        NcRender,
+        Frame,
+        PhaseCount
+    };
+    static const char *phaseName(Phase p);
+
+    void record(Phase p, uint64_t ns)
+    {
+        window[p].push(ns);
+        hist[p].record(ns);
+    }
+    // Call once per loop iteration with the current time and the number of
+    // ticks it ran (a fast replay runs a burst); updates the rates
+    void frameDone(uint64_t nowNs, uint32_t ticks);
+
+    // Full histograms for every phase
+    void dump(std::ostream &out) const;
+
+    std::array<SampleWindow, PhaseCount> window;
+    std::array<LatencyHistogram, PhaseCount> hist;
+    double ticksPerSec{0.0};
+    double framesPerSec{0.0};
+
+private:
+    bool rateStarted{false};
+    uint64_t rateStart{0};
+    uint64_t rateTicks{0};
+    uint64_t rateFrames{0};
+};
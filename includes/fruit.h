@@ -1,13 +1,36 @@
 #pragma once
 #include "point.h"
+#include "trace.h"
 #include <random>
 
 class Fruit
 {
 public:
     Fruit(int width, int height);
+    // Deterministic placement sequence for reproducible sessions
+    Fruit(int width, int height, unsigned seed);
+
+    // Restart the placement sequence without rebuilding the Fruit
+    void reseed(unsigned seed)
+    {
+        rng.seed(seed);
+        currentSeed = seed;
+    }
+    void reseed();
+    // Seed of the current placement sequence (recorded with each game)
+    unsigned seed() const { return currentSeed; }
 
     const Point &position() const { return pos; }
+    // Put the fruit back where it was (rewind); the generator is left as is
+    void place(const Point &p) { pos = p; }
+    // Placement generator state, for save files
+    const std::mt19937 &generator() const { return rng; }
+    void restore(const Point &p, unsigned seed, const std::mt19937 &state)
+    {
+        pos = p;
+        currentSeed = seed;
+        rng = state;
+    }
     // Respawn fruit at a random free position not overlapping the snake
     template <typename ContainsFn>
     void respawn(ContainsFn &&isOccupied);
@@ -17,11 +40,13 @@ private:
     int height;
     Point pos{0, 0};
     std::mt19937 rng;
+    unsigned currentSeed{0};
 };
 
 template <typename ContainsFn>
 void Fruit::respawn(ContainsFn &&isOccupied)
 {
+    TraceSpan span("Fruit::respawn");
     std::uniform_int_distribution<int> dx(1, width - 2);  // inside borders
     std::uniform_int_distribution<int> dy(1, height - 2); // inside borders
     for (int tries = 0; tries < 1000; ++tries)
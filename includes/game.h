@@ -1,8 +1,22 @@
 #pragma once
 #include "snake.h"
 #include "fruit.h"
+#include "asciicast.h"
+#include "clock.h"
+#include "input.h"
+#include "level.h"
+#include "level_gen.h"
+#include "frame_stats.h"
+#include "flight_recorder.h"
+#include "leaderboard.h"
+#include "score_journal.h"
+#include "replay.h"
+#include "rewind.h"
+#include <memory>
 #include <string>
 
+struct ncplane;
+
 class Game
 {
 public:
@@ -13,7 +27,76 @@ public:
     // Run the game loop (blocking). Returns final score.
     int run();
 
+    // Replace the time / key source, e.g. VirtualClock + ScriptedInput to
+    // drive a whole session at full CPU speed. Not owned by the Game.
+    void setClock(Clock &c) { clock = &c; }
+    void setInputSource(InputSource &in) { input = &in; }
+    // Skip Notcurses entirely: no terminal, keys only from setInputSource()
+    void setHeadless(bool on) { headless = on; }
+    // Draw into a Notcurses context owned by the caller (offscreen render
+    // benchmarks) rather than one created by run(); nullptr detaches
+    void attachNotcurses(notcurses *nc);
+    // Seed fruit placement so a scripted session plays out the same every time
+    void setSeed(unsigned s);
+    // Play on a level file instead of the plain walled board; the board
+    // takes the level's size. False if path isn't a valid level. Call before
+    // setReplay() and run().
+    bool loadLevel(const std::string &path);
+    // Same, with a level already in memory (a generated board a replay was
+    // recorded on)
+    void setLevel(Level &&l);
+    // A fresh generated board for every game, drawn from the fruit seed so
+    // the replay can rebuild it. Such games aren't saved.
+    void setLevelStyle(LevelStyle s);
+    // Write the full per-phase frame-time histograms here when run() returns
+    void setStatsFile(const std::string &path) { statsFile = path; }
+    // Ring file for the flight recorder (default "flight.rec"); "" disables
+    void setFlightRecorderFile(const std::string &path) { flightFile = path; }
+    // Shared top-K leaderboard file (default "leaderboard.dat", opened by
+    // run()); "" keeps scores in memory only (harnesses). An empty table
+    // takes the score from an old highscore.txt beside it.
+    void setLeaderboardFile(const std::string &path);
+    // Score history files <base>.journal / <base>.snapshot (default
+    // "scores", opened by run()); "" records nothing
+    void setHistoryFile(const std::string &base);
+    // Suspended-game file (default "savegame.dat"): written on pause and on
+    // quitting mid-run, resumed by run(); "" disables save and resume
+    void setSaveFile(const std::string &path) { saveFile = path; }
+    // Directory receiving a replay of every finished game (default
+    // "replays"); "" disables recording
+    void setReplayDir(const std::string &dir) { replayDir = dir; }
+    // Play r back instead of taking steering keys. False, and nothing
+    // changes, unless the board is the level r was recorded on.
+    // fast runs ticks back to back instead of at the recorded rate ('f'
+    // toggles). '[' / ']' jump 1000 ticks and 'j' goes to a tick, via
+    // keyframes built here. Playback never touches saves, history,
+    // leaderboard or replays. r must outlive run().
+    bool setReplay(const Replay &r, bool fast = false);
+    // Practice mode: 'b' rewinds about three seconds, also after dying.
+    // Practice games never reach the leaderboard, history or replays, and
+    // aren't saved.
+    void setPracticeMode(bool on);
+    // Record the terminal output as an asciicast v2 file. Live, the output
+    // still reaches the terminal; offscreen, run() draws into a hidden
+    // terminal sized for the board instead, so a session (a replay on a
+    // VirtualClock, say) exports at full speed with no terminal at all.
+    void setCastFile(const std::string &path, bool offscreen = false)
+    {
+        castFile = path;
+        castOffscreen = offscreen;
+    }
+    // Called at the end of every loop iteration, before the sleep. Plain
+    // function pointer so installing it doesn't allocate.
+    void setFrameHook(void (*fn)(void *ctx), void *ctx)
+    {
+        frameHook = fn;
+        frameHookCtx = ctx;
+    }
+
 private:
+    // bench/ harnesses drive update() and set up board states directly
+    friend struct GameProbe;
+
     enum class SnakeGlyphStyle
     {
         Light,
@@ -31,21 +114,40 @@ private:
         None,
         Pause,
         GameOver,
-        EnterName
+        EnterName,
+        GoToTick
     };
     void processInput();
     void update();
     void render() const;
+    void drawBoardLayer(int xscale) const;
+    void destroyBoardLayer() const;
+    void renderStats(int oy, int hx) const;
+    void renderLeaderboard(int oy, int hx) const;
 
     void reset();
+    void newBoard();
     void chooseDifficulty();
-    void loadHighScore();
-    void saveHighScore();
+    void refreshLeaderboard();
+    void importHighScore(const std::string &leaderboardPath);
+    void submitScore();
+    void endGame();
+    void recordGame();
+    bool saveGame();
+    bool resumeGame();
+    void saveReplay();
+    void seekReplay(uint64_t target);
+    void rewindTicks(int n);
     void openDialog(DialogType t);
     void closeDialog();
 
     int width;
     int height;
+    // Walls and spawn point: the plain rectangle unless loadLevel(), or
+    // redrawn by levelGen every game after setLevelStyle() (levelStyle != 0)
+    Level level;
+    LevelGenerator levelGen;
+    uint32_t levelStyle{0};
     Snake snake;
     Fruit fruit;
     int score{0};
@@ -56,11 +158,65 @@ private:
     DialogType dialogType{DialogType::None};
     int dialogIndex{0};
     std::string playerName{"Player"};
-    // Temporary storage for name entry when EnterName dialog is open
+    // Text typed into the EnterName (or GoToTick) dialog
     std::string nameEntry{""};
     int nameMaxLen{24};
     int tickMs{120};
     int highScore{0};
-    std::string highScoreFile{"highscore.txt"};
+    // Local copy of the shared table, refreshed when its generation moves
+    Leaderboard leaderboard;
+    std::string leaderboardFile{"leaderboard.dat"};
+    LeaderboardEntry top[Leaderboard::Capacity]{};
+    int topCount{0};
+    uint64_t topGeneration{~0ull};
+    // Finished score waiting for the leaderboard (another instance was
+    // mid-update); retried every frame
+    int pendingScore{-1};
+    // Every finished game, appended by a background writer
+    ScoreJournal journal;
+    std::string historyBase{"scores"};
+    std::string saveFile{"savegame.dat"};
+    // Quit with the run saved for later: not a finished game yet
+    bool suspended{false};
+    // Turns of the current game (invalid after resuming a save, whose
+    // start the replay can't describe) and a replay being played back
+    ReplayWriter recording;
+    bool recordingValid{false};
+    std::string replayDir{"replays"};
+    const Replay *replay{nullptr};
+    ReplayCursor replayCursor;
+    ReplayIndex replayIndex;
+    bool replayFast{false};
+    // Practice mode: what each recent tick changed, newest last
+    bool practice{false};
+    RewindBuffer rewindBuf;
     SnakeGlyphStyle snakeStyle{SnakeGlyphStyle::Heavy};
+    // Border, walls and grid dots, drawn once into a plane under the
+    // standard plane and redrawn only when the horizontal scale changes
+    mutable ncplane *boardLayer{nullptr};
+    mutable int boardLayerScale{0};
+    mutable int boardLayerY{0}, boardLayerX{0};
+
+    // Loop timing and key input; defaults are created in run()
+    Clock *clock{nullptr};
+    InputSource *input{nullptr};
+    std::unique_ptr<Clock> ownedClock;
+    std::unique_ptr<InputSource> ownedInput;
+    bool headless{false};
+    // Frame timing overlay (toggled with 't') and histogram dump
+    FrameStats stats;
+    bool showStats{false};
+    std::string statsFile;
+    // Ticks since the last reset, and the last key seen since the previous tick
+    uint64_t tick{0};
+    uint32_t lastKey{0};
+    FlightRecorder recorder;
+    std::string flightFile{"flight.rec"};
+    AsciicastRecorder cast;
+    std::string castFile;
+    bool castOffscreen{false};
+    void (*frameHook)(void *){nullptr};
+    void *frameHookCtx{nullptr};
+    bool seeded{false};
+    unsigned seed{0};
 };
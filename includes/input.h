@@ -0,0 +1,61 @@
+// Key sources for the game loop
+#pragma once
+#include "clock.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct notcurses;
+
+// Non-blocking key source. poll() follows notcurses_get_nblock(): it returns
+// 0 when nothing is pending and (uint32_t)-1 on error.
+class InputSource
+{
+public:
+    virtual ~InputSource() = default;
+    virtual uint32_t poll() = 0;
+};
+
+// Live keyboard input from a Notcurses context
+class NotcursesInput : public InputSource
+{
+public:
+    explicit NotcursesInput(notcurses *nc) : nc(nc) {}
+    uint32_t poll() override;
+
+private:
+    notcurses *nc;
+};
+
+// Replays keys from a text file, one "<ms> <key>" per line. Timestamps are
+// milliseconds since the first poll, measured on the supplied clock. Keys are
+// a single character or one of: up down left right enter space backspace
+// esc, or a numeric codepoint (e.g. 0x71). '#' starts a comment.
+class ScriptedInput : public InputSource
+{
+public:
+    explicit ScriptedInput(const Clock &clock) : clock(clock) {}
+
+    // Returns false if the file can't be read or a line doesn't parse
+    bool load(const std::string &path);
+    void push(int64_t ms, uint32_t key) { events.push_back({ms, key}); }
+    uint32_t poll() override;
+    bool exhausted() const { return next >= events.size(); }
+
+    // Once the script runs out, send a single 'q' so a session always ends
+    // (the name dialog must already be closed for it to act as quit)
+    bool quitWhenDone{true};
+
+private:
+    struct Event
+    {
+        int64_t ms;
+        uint32_t key;
+    };
+    const Clock &clock;
+    std::vector<Event> events;
+    size_t next{0};
+    bool started{false};
+    bool quitSent{false};
+    Clock::time_point start{};
+};
@@ -0,0 +1,53 @@
+// Shared top-K leaderboard in a memory-mapped file
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// One ranked score. Fixed 40 bytes so the table is a flat array in the file.
+struct LeaderboardEntry
+{
+    int32_t score;
+    uint32_t reserved;
+    uint64_t timeSec; // wall clock when the score was submitted
+    char name[24];    // NUL-terminated, truncated to fit
+};
+static_assert(sizeof(LeaderboardEntry) == 40, "LeaderboardEntry is an on-disk layout");
+
+// File layout: 64-byte header, then two tables of Capacity entries. The header
+// word `state` holds a generation counter and which table is current; a writer
+// fills the other table, checksums it and publishes it by storing `state`, so
+// a crash mid-update leaves the current table intact. Writers claim the file
+// with a compare-and-swap of their pid into `writer` (taking it over if that
+// pid is dead). Every running instance maps the same pages, so a published
+// update is visible to all of them at once.
+class Leaderboard
+{
+public:
+    static constexpr int Capacity = 10;
+
+    Leaderboard() = default;
+    ~Leaderboard() { close(); }
+    Leaderboard(const Leaderboard &) = delete;
+    Leaderboard &operator=(const Leaderboard &) = delete;
+
+    // Create or map the file; an unrecognised file is reinitialised
+    bool open(const std::string &path);
+    void close();
+    bool isOpen() const { return base != nullptr; }
+
+    // Insert a score if it makes the top K. Never waits: returns false when
+    // another instance is mid-update, so the caller retries on a later frame.
+    bool submit(const char *name, int score, uint64_t timeSec);
+
+    // One atomic load; changes whenever any instance publishes
+    uint64_t generation() const;
+
+    // Copy out the current table (best first); returns the entry count, or 0
+    // if the file is closed or no consistent table could be read
+    int snapshot(LeaderboardEntry *out) const;
+
+private:
+    void *base{nullptr};
+    size_t mapSize{0};
+};
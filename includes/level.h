@@ -0,0 +1,155 @@
+// Levels: board size, spawn point and a bit-packed wall mask, in a file
+// that is mapped and used as is
+#pragma once
+#include "point.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+// How heads cross the board's edges
+enum class Topology : uint32_t
+{
+    Walled = 0, // the border kills
+    Torus = 1   // a head stepping onto the border comes in on the opposite side
+};
+
+// Two wall cells off the border joined as a portal: a head stepping onto
+// one leaves the other in the same direction
+struct LevelPortal
+{
+    int32_t ax, ay;
+    int32_t bx, by;
+};
+static_assert(sizeof(LevelPortal) == 16, "LevelPortal is an on-disk layout");
+
+// File layout: this header, then the wall mask at maskOffset, one bit per
+// cell in row order (cell y * width + x is bit i % 64 of word i / 64),
+// 1 = wall, then portalCount LevelPortals at portalOffset. The border is
+// always wall, so a head only ever steps onto a board cell; a torus and
+// portals only change which one.
+struct LevelHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t headerSize;
+    int32_t width;
+    int32_t height;
+    int32_t spawnX; // head of the starting snake; it faces right, body to the left
+    int32_t spawnY;
+    uint64_t maskOffset;
+    uint64_t maskWords;
+    uint64_t wallCount;
+    uint64_t id; // FNV-1a of size, spawn and mask, never 0; kept in replays and saves
+    char name[32];
+    uint32_t topology; // Topology; 0 in files from before it existed
+    uint32_t portalCount;
+    uint64_t portalOffset;
+    uint8_t reserved[16];
+};
+static_assert(sizeof(LevelHeader) == 128, "LevelHeader is an on-disk layout");
+
+namespace level_file
+{
+    inline size_t maskWords(int width, int height) { return ((size_t)width * (size_t)height + 63) / 64; }
+    inline void setWall(uint64_t *mask, int width, const Point &p)
+    {
+        size_t i = (size_t)p.y * (size_t)width + (size_t)p.x;
+        mask[i >> 6] |= 1ull << (i & 63);
+    }
+    // Why a board can't be played (border not all wall, spawn or the two
+    // cells behind it blocked or off the board, a portal end off the walls,
+    // on the border or shared), or nullptr
+    const char *check(int width, int height, const Point &spawn, const uint64_t *mask,
+                      const LevelPortal *portals = nullptr, size_t portalCount = 0);
+    // LevelHeader::id for a board (never 0). Topology and portals count
+    // only when present, so walled boards keep the id they always had.
+    uint64_t idOf(int width, int height, const Point &spawn, const uint64_t *mask,
+                  Topology topology = Topology::Walled, const LevelPortal *portals = nullptr,
+                  size_t portalCount = 0);
+    // Written beside path and renamed into place. The board must pass check().
+    bool write(const std::string &path, int width, int height, const Point &spawn, const uint64_t *mask,
+               const char *name, Topology topology = Topology::Walled, const LevelPortal *portals = nullptr,
+               size_t portalCount = 0);
+}
+
+// The board the game is played on. File levels are mapped read-only and
+// never parsed: open() checks the header, the file size, the border and the
+// spawn, and the mask is used where it lies. Moves go through a neighbour
+// table (cell x direction -> the cell a head lands on, or a wall) built
+// when the board is set, so the torus and portals cost the rules nothing.
+class Level
+{
+public:
+    Level() = default;
+    ~Level() { close(); }
+    Level(Level &&o) noexcept { *this = std::move(o); }
+    Level &operator=(Level &&o) noexcept;
+    Level(const Level &) = delete;
+    Level &operator=(const Level &) = delete;
+
+    // The plain board: walls on the border only, spawn in the middle, id 0
+    static Level rectangle(int width, int height);
+    // A board built in memory (LevelGenerator): draw() gives an all-free
+    // width x height mask, reusing this level's storage, and commit() sets
+    // the spawn and the id. generator is the LevelStyle that drew it.
+    uint64_t *draw(int width, int height);
+    void commit(const Point &spawn, uint32_t generator);
+
+    bool open(const std::string &path);
+    void close();
+
+    int width() const { return w; }
+    int height() const { return h; }
+    const Point &spawn() const { return start; }
+    uint64_t id() const { return levelId; }
+    const char *name() const { return levelName; }
+    // LevelStyle of a generated board, 0 for files and the plain board
+    uint32_t generator() const { return gen; }
+    Topology topology() const { return topo; }
+    const std::vector<LevelPortal> &portals() const { return portalList; }
+    const uint64_t *mask() const { return bits; }
+
+    // One bit test; p must be on the board
+    bool wall(const Point &p) const
+    {
+        size_t i = (size_t)p.y * (size_t)w + (size_t)p.x;
+        return (bits[i >> 6] >> (i & 63)) & 1;
+    }
+
+    // Where a head on the free cell from lands going d: false for a wall.
+    // One table load; boards over kLinkedCells, whose table wouldn't be
+    // worth its memory, work the step out each time instead.
+    bool step(const Point &from, Direction d, Point &to) const
+    {
+        size_t i = (size_t)from.y * (size_t)w + (size_t)from.x;
+        uint32_t n = links.empty() ? linkOf(from, d) : links[i * 4 + (size_t)d];
+        to = {(int)(n & 0xffff), (int)(n >> 16)};
+        return n != kNoLink;
+    }
+
+    static constexpr size_t kLinkedCells = size_t(1) << 20;
+
+private:
+    // Table entries: y << 16 | x of the destination. No cell has both
+    // coordinates 65535, so that value means a wall.
+    static constexpr uint32_t kNoLink = ~0u;
+    uint32_t linkOf(const Point &from, Direction d) const;
+    // Rebuilds links and portalExits for the current board
+    void link();
+
+    void *base{nullptr};
+    size_t mapSize{0};
+    std::vector<uint64_t> owned; // rectangle()
+    const uint64_t *bits{nullptr};
+    int w{0}, h{0};
+    Point start{0, 0};
+    uint64_t levelId{0};
+    uint32_t gen{0};
+    char levelName[32]{};
+    Topology topo{Topology::Walled};
+    std::vector<LevelPortal> portalList;
+    std::vector<std::pair<size_t, Point>> portalExits; // portal cell -> the other end, by cell
+    std::vector<uint32_t> links;                         // 4 per cell, Direction order
+};
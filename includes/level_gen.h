@@ -0,0 +1,62 @@
+// Seeded obstacle layouts: mazes, rooms and scattered blocks, drawn into a
+// Level's wall mask with every free cell reachable from the spawn
+#pragma once
+#include "level.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+enum class LevelStyle : uint32_t
+{
+    Maze = 1,  // corridors one cell wide, with some loops so a long snake can turn back
+    Rooms = 2, // open rectangles joined by corridors
+    Blocks = 3 // the plain board with small wall blocks scattered over it
+};
+
+// "maze", "rooms", "blocks"
+bool parseLevelStyle(const char *s, LevelStyle &out);
+const char *levelStyleName(LevelStyle s);
+
+// Draws a board from (style, width, height, seed) alone, so a replay or a
+// save can rebuild it from its header. Every style starts the snake in a
+// straight run of free cells, and ends with a flood fill from the spawn
+// that walls up any free cell it didn't reach, so all free cells are
+// connected. Scratch buffers are kept between calls: once warmed up for a
+// board size, generate() doesn't allocate.
+class LevelGenerator
+{
+public:
+    // Boards smaller than 7x5 get the plain layout. false if width or
+    // height is out of range for a level.
+    bool generate(LevelStyle style, int width, int height, uint64_t seed, Level &out);
+
+    // Free cells reachable from level's spawn (a separate check; generate()
+    // guarantees it equals freeCells())
+    size_t reachable(const Level &level);
+    static size_t freeCells(const Level &level);
+
+private:
+    void maze(uint64_t *m, int w, int h, Point &spawn);
+    void rooms(uint64_t *m, int w, int h, Point &spawn);
+    void blocks(uint64_t *m, int w, int h, Point &spawn);
+    // Flood fill from spawn into seen; returns the cells reached
+    size_t fill(const uint64_t *m, int w, int h, const Point &spawn);
+
+    // splitmix64: fixed output for a seed on every platform, unlike the
+    // standard distributions
+    uint64_t next()
+    {
+        uint64_t z = (rng += 0x9e3779b97f4a7c15ull);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+        return z ^ (z >> 31);
+    }
+    // 0 .. n-1
+    uint32_t below(uint32_t n) { return (uint32_t)(((next() >> 32) * n) >> 32); }
+
+    uint64_t rng{0};
+    std::vector<uint32_t> parent; // maze: union-find over lattice cells
+    std::vector<uint32_t> edges;  // maze: lattice edges in random order
+    std::vector<uint32_t> queue;  // flood fill
+    std::vector<uint64_t> seen;   // flood fill, one bit per cell
+};
@@ -0,0 +1,44 @@
+// Process metrics in Prometheus text exposition format
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// Updated from the game loop with relaxed atomics only; a background
+// exporter snapshots them and rewrites a text file (textfile-collector
+// style), so the loop never blocks on I/O or locks.
+struct Metrics
+{
+    // Counters
+    std::atomic<uint64_t> ticks{0};
+    std::atomic<uint64_t> frames{0};
+    std::atomic<uint64_t> inputEvents{0};
+    std::atomic<uint64_t> terminalBytes{0};
+    // Gauges
+    std::atomic<int64_t> tickJitterNs{0};
+    std::atomic<uint64_t> renderNs{0};
+    std::atomic<uint64_t> snakeLength{0};
+
+    // Set by the exporter after each snapshot: the game loop refreshes
+    // terminalBytes (a notcurses_stats() call) on its next frame and clears
+    // it, so the counter is sampled once per export instead of every frame
+    std::atomic<bool> wantTerminalStats{true};
+
+    void count(std::atomic<uint64_t> &c, uint64_t n = 1) { c.fetch_add(n, std::memory_order_relaxed); }
+    template <typename T>
+    void set(std::atomic<T> &g, T v) { g.store(v, std::memory_order_relaxed); }
+};
+
+// Process-wide instance
+Metrics &metrics();
+
+namespace metrics_export
+{
+    // Rewrite path every intervalMs (write to path.tmp, then rename, so
+    // readers never see a partial file). Returns false if already running.
+    bool start(const std::string &path, int intervalMs = 5000);
+    // Write one final snapshot and join the exporter thread
+    void stop();
+    // Current snapshot in exposition format (also adds RSS)
+    std::string render();
+}
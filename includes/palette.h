@@ -0,0 +1,48 @@
+// Board colours, shared by the terminal renderer and the video rasterizer
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+namespace palette
+{
+    struct Rgb
+    {
+        uint8_t r, g, b;
+    };
+
+    // Board border: bluish (120,160,255) to aqua (120,255,200)
+    inline Rgb border(float t)
+    {
+        int r1 = 120, g1 = 160, b1 = 255, r2 = 120, g2 = 255, b2 = 200;
+        return {(uint8_t)(r1 + (r2 - r1) * t), (uint8_t)(g1 + (g2 - g1) * t), (uint8_t)(b1 + (b2 - b1) * t)};
+    }
+
+    // Snake body, t = 0 at the head to 1 at the tail: lime, yellow, cyan
+    inline Rgb snake(float t)
+    {
+        int r0 = 80, g0 = 255, b0 = 120; // lime
+        int r1 = 255, g1 = 220, b1 = 0;  // yellow
+        int r2 = 0, g2 = 220, b2 = 255;  // cyan
+        if (t <= 0.5f)
+        {
+            float u = t * 2.0f;
+            return {(uint8_t)(r0 + (int)((r1 - r0) * u)), (uint8_t)(g0 + (int)((g1 - g0) * u)),
+                    (uint8_t)(b0 + (int)((b1 - b0) * u))};
+        }
+        float u = (t - 0.5f) * 2.0f;
+        return {(uint8_t)(r1 + (int)((r2 - r1) * u)), (uint8_t)(g1 + (int)((g2 - g1) * u)),
+                (uint8_t)(b1 + (int)((b2 - b1) * u))};
+    }
+
+    // Grid dots, two subtle greys in a checker pattern
+    inline Rgb grid(bool alt) { return alt ? Rgb{70, 75, 85} : Rgb{55, 60, 70}; }
+
+    constexpr Rgb fruit{255, 80, 80};
+
+    // Portal pairs, told apart by colour: magenta, orange, violet, gold
+    inline Rgb portal(size_t pair)
+    {
+        static constexpr Rgb hues[4] = {{255, 90, 220}, {255, 150, 40}, {170, 110, 255}, {240, 210, 60}};
+        return hues[pair % 4];
+    }
+}
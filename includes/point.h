@@ -1,4 +1,4 @@
-// Simple 2D integer point
+// Simple 2D integer point, and the four directions between cells
 #pragma once
 
 struct Point
@@ -7,3 +7,19 @@ struct Point
     int y;
     bool operator==(const Point &other) const { return x == other.x && y == other.y; }
 };
+
+enum class Direction
+{
+    Up,
+    Down,
+    Left,
+    Right
+};
+
+// The cell next to p in direction d, on an unbounded grid
+inline Point neighbour(const Point &p, Direction d)
+{
+    static constexpr int dx[4] = {0, 0, -1, 1};
+    static constexpr int dy[4] = {-1, 1, 0, 0};
+    return {p.x + dx[(int)d], p.y + dy[(int)d]};
+}
@@ -0,0 +1,159 @@
+// Pseudo-terminal helpers: offscreen Notcurses output (render benchmark,
+// allocation check, offline cast export) and the latency harness
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <unistd.h>
+
+namespace term
+{
+    // Master/slave pair with a fixed window size; slave in raw mode
+    struct Pty
+    {
+        int master{-1};
+        int slave{-1};
+
+        bool open(unsigned rows, unsigned cols)
+        {
+            master = posix_openpt(O_RDWR | O_NOCTTY);
+            if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0)
+                return false;
+            const char *name = ptsname(master);
+            if (!name)
+                return false;
+            slave = ::open(name, O_RDWR | O_NOCTTY);
+            if (slave < 0)
+                return false;
+            struct winsize ws{};
+            ws.ws_row = (unsigned short)rows;
+            ws.ws_col = (unsigned short)cols;
+            ioctl(slave, TIOCSWINSZ, &ws);
+            struct termios t{};
+            if (tcgetattr(slave, &t) == 0)
+            {
+                cfmakeraw(&t);
+                tcsetattr(slave, TCSANOW, &t);
+            }
+            return true;
+        }
+
+        void close()
+        {
+            if (slave >= 0)
+                ::close(slave);
+            if (master >= 0)
+                ::close(master);
+            slave = master = -1;
+        }
+    };
+
+    // Notcurses waits on a couple of terminal replies at startup. Feed each
+    // chunk read from the master through this; it answers primary device
+    // attributes and cursor position reports, each query exactly once, in
+    // order, including queries split across reads.
+    class QueryResponder
+    {
+    public:
+        void scan(int masterFd, const char *buf, size_t n)
+        {
+            std::string window = tail + std::string(buf, n);
+            // Only bytes past the last answered query carry over, so a
+            // query left in the tail isn't answered again on the next read
+            size_t done = 0;
+            for (size_t at = window.find('\x1b'); at != std::string::npos; at = window.find('\x1b', at + 1))
+            {
+                size_t len = 0;
+                if (window.compare(at, 3, "\x1b[c") == 0)
+                    len = 3;
+                else if (window.compare(at, 4, "\x1b[0c") == 0)
+                    len = 4;
+                if (len)
+                    reply(masterFd, "\x1b[?62;22c");
+                else if (window.compare(at, 4, "\x1b[6n") == 0)
+                {
+                    len = 4;
+                    reply(masterFd, "\x1b[1;1R");
+                }
+                if (len)
+                {
+                    done = at + len;
+                    at = done - 1;
+                }
+            }
+            tail = window.substr(std::max(done, window.size() > 8 ? window.size() - 8 : 0));
+        }
+
+    private:
+        static void reply(int fd, const char *s)
+        {
+            ssize_t w = write(fd, s, std::strlen(s));
+            (void)w;
+        }
+        std::string tail;
+    };
+
+    // Offscreen terminal: Notcurses writes to the pty slave, a thread drains
+    // the master and answers the few queries Notcurses waits on at startup
+    // (primary device attributes, cursor position).
+    class PtySink
+    {
+    public:
+        ~PtySink() { close(); }
+
+        bool open(unsigned rows, unsigned cols)
+        {
+            if (!pty.open(rows, cols))
+                return false;
+            stopping = false;
+            drainer = std::thread([this]
+                                  { drain(); });
+            return true;
+        }
+
+        void close()
+        {
+            if (drainer.joinable())
+            {
+                stopping = true;
+                drainer.join();
+            }
+            pty.close();
+        }
+
+        int slaveFd() const { return pty.slave; }
+        uint64_t bytes() const { return drained.load(std::memory_order_relaxed); }
+
+    private:
+        void drain()
+        {
+            char buf[1 << 16];
+            QueryResponder responder;
+            while (!stopping)
+            {
+                struct pollfd pfd{pty.master, POLLIN, 0};
+                if (poll(&pfd, 1, 20) <= 0)
+                    continue;
+                ssize_t n = read(pty.master, buf, sizeof buf);
+                if (n <= 0)
+                    continue;
+                drained.fetch_add((uint64_t)n, std::memory_order_relaxed);
+                responder.scan(pty.master, buf, (size_t)n);
+            }
+        }
+
+        Pty pty;
+        std::thread drainer;
+        std::atomic<bool> stopping{false};
+        std::atomic<uint64_t> drained{0};
+    };
+}
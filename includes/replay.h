@@ -0,0 +1,286 @@
+// Replays: the starting conditions plus every direction change, enough to
+// re-run a game through the same rules
+#pragma once
+#include "fruit.h"
+#include "level.h"
+#include "rules.h"
+#include "snake.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// File layout: this header, then one varint per turn holding
+// (ticks since the previous turn << 2) | Direction. A game starts as
+// Game::reset() leaves it: length 3 at the level's spawn (the middle of the
+// plain board) facing right, with the fruit placed from `seed`.
+struct ReplayHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t headerSize;
+    int32_t width;
+    int32_t height;
+    int32_t tickMs;
+    uint32_t seed;    // fruit placement seed
+    uint64_t ticks;   // length of the game; the last tick ends it
+    uint64_t timeSec; // wall clock when it was recorded
+    int32_t score;    // final score, as claimed by the recorder
+    uint32_t turns;
+    uint32_t length; // final snake length
+    uint32_t generator; // LevelStyle of a generated board (rebuilt from seed), else 0
+    char name[24];
+    uint64_t level; // Level::id() of the board, 0 for the plain walled rectangle
+};
+static_assert(sizeof(ReplayHeader) == 96, "ReplayHeader is an on-disk layout");
+
+// A header for a new game: magic, version and starting conditions, the rest zero
+ReplayHeader newReplayHeader(int width, int height, int tickMs, unsigned seed, uint64_t level = 0);
+
+// The board a replay was recorded on
+inline bool levelMatches(const ReplayHeader &h, const Level &l)
+{
+    return h.level == l.id() && h.width == l.width() && h.height == l.height();
+}
+
+// Rebuild the board from the header alone: the plain board, or a generated
+// one from its style and the seed. false for boards from level files (those
+// have to be passed in) and for a generated board that comes out different.
+bool replayBoard(const ReplayHeader &h, Level &out);
+
+// Collects turns while a game is played. Storage is reserved up front, so
+// recording doesn't allocate during normal play.
+class ReplayWriter
+{
+public:
+    ReplayWriter() { turnBytes.reserve(64 * 1024); }
+
+    // Start a new game
+    void begin(const Level &level, int tickMs, unsigned seed);
+    // Called once per tick, before the move, with the direction in effect
+    void step(uint64_t tick, Direction d)
+    {
+        if (d == last)
+            return;
+        put(((tick - lastTick) << 2) | (uint64_t)d);
+        lastTick = tick;
+        last = d;
+        ++header.turns;
+    }
+    // Write the finished game; plain syscalls, no allocation
+    bool save(const char *path, uint64_t ticks, int score, uint32_t length, const char *name) const;
+
+private:
+    void put(uint64_t v)
+    {
+        while (v >= 0x80)
+        {
+            turnBytes.push_back((uint8_t)(v | 0x80));
+            v >>= 7;
+        }
+        turnBytes.push_back((uint8_t)v);
+    }
+
+    ReplayHeader header{};
+    std::vector<uint8_t> turnBytes;
+    uint64_t lastTick{0};
+    Direction last{Direction::Right};
+};
+
+// A replay file mapped read-only
+class Replay
+{
+public:
+    Replay() = default;
+    ~Replay() { close(); }
+    Replay(const Replay &) = delete;
+    Replay &operator=(const Replay &) = delete;
+
+    bool open(const std::string &path);
+    void close();
+    bool isOpen() const { return base != nullptr; }
+
+    const ReplayHeader &header() const { return *static_cast<const ReplayHeader *>(base); }
+    const uint8_t *turns() const { return static_cast<const uint8_t *>(base) + sizeof(ReplayHeader); }
+    size_t turnBytes() const { return mapSize - sizeof(ReplayHeader); }
+
+private:
+    void *base{nullptr};
+    size_t mapSize{0};
+};
+
+// Walks a replay's turns in tick order
+class ReplayCursor
+{
+public:
+    ReplayCursor() = default;
+    explicit ReplayCursor(const Replay &r) { reset(r.turns(), r.turnBytes()); }
+    void reset(const uint8_t *turns, size_t bytes);
+
+    // The turn recorded for this tick, if any. Ticks must not go backwards.
+    bool turnAt(uint64_t tick, Direction &d)
+    {
+        if (!pending || nextTick != tick)
+            return false;
+        d = nextDir;
+        decode();
+        return true;
+    }
+    // Every turn has been handed out
+    bool done() const { return !pending; }
+    // Tick of the next turn, ~0 when there is none
+    uint64_t nextTurn() const { return pending ? nextTick : ~0ull; }
+
+private:
+    void decode();
+
+    const uint8_t *p{nullptr};
+    const uint8_t *end{nullptr};
+    uint64_t nextTick{0};
+    Direction nextDir{Direction::Right};
+    bool pending{false};
+};
+
+// Spots a replay that has gone periodic. While the snake neither turns nor
+// grows, its head follows a fixed path through the board's topology; once
+// that path has closed into a cycle and the snake has survived a full lap
+// plus its own length, every later state is an earlier one, so it can never
+// die. Brent's cycle search on the head: O(1) per tick, and it finds cycles
+// a portal enters part-way. This bounds a simulation by the replay's content
+// rather than its (unchecked) claimed length.
+class ReplayLoop
+{
+public:
+    // Forget the current run, e.g. after skipping ahead
+    void reset() { fresh = true; }
+
+    // Call after every step the snake survives, with the tick it ended;
+    // changed if a turn was handed out or the snake grew. True once the
+    // state is known to recur every period() ticks for as long as no turn
+    // arrives.
+    bool step(uint64_t tick, const Snake &snake, bool changed)
+    {
+        const Point &head = snake.head();
+        if (changed || fresh)
+        {
+            // Start looking again from here
+            fresh = false;
+            length = snake.segments().size();
+            mark(head);
+            power = 1;
+            lap = 0;
+            return false;
+        }
+        if (lap != 0)
+            return tick >= confirmAt;
+        ++steps;
+        if (head == ref)
+        {
+            lap = steps;
+            confirmAt = tick + length;
+        }
+        else if (steps == power)
+        {
+            mark(head);
+            power *= 2;
+        }
+        return false;
+    }
+    uint64_t period() const { return lap; }
+
+private:
+    void mark(const Point &head)
+    {
+        ref = head;
+        steps = 0;
+    }
+
+    bool fresh{true};
+    Point ref{0, 0};
+    size_t length{0};
+    uint64_t power{1};
+    uint64_t steps{0};
+    uint64_t lap{0};
+    uint64_t confirmAt{0};
+};
+
+// Fresh-game state a replay starts from, as Game::reset() leaves it. level
+// must be the replay's (levelMatches()).
+void replayStart(const Replay &r, const Level &level, Snake &snake, Fruit &fruit, ReplayCursor &cursor);
+
+// Outcome of re-running a replay from its header and turns alone
+struct ReplayCheck
+{
+    bool valid{false};     // the header describes a playable board, the given level
+    uint64_t ticks{0};     // tick the simulated game ended on, or was stopped at
+    int score{0};
+    uint32_t length{0};
+    bool turnsLeft{false}; // turns recorded after the simulated death
+    bool alive{false};     // outlived the claimed end, or can never die
+
+    // Everything the recorder claimed was reproduced
+    bool matches(const ReplayHeader &h) const
+    {
+        return valid && !turnsLeft && !alive && ticks == h.ticks && score == h.score && length == h.length;
+    }
+};
+
+// Simulate a whole replay on level through stepRules until the snake dies,
+// or stop with alive set one tick past the claimed end, or once the game has
+// gone periodic with no turn left to change it (ReplayLoop): on a torus a
+// snake that never turns runs forever. Laps before a later turn are skipped,
+// so the work follows the replay's content, not its claimed length.
+ReplayCheck checkReplay(const ReplayHeader &h, const Level &level, const uint8_t *turns, size_t bytes);
+
+// Full game state at one tick of a replay
+struct ReplayKeyframe
+{
+    uint64_t tick{0};
+    int score{0};
+    Direction dir{Direction::Right};
+    std::vector<Point> body; // head first
+    Point fruit{0, 0};
+    unsigned fruitSeed{0};
+    std::mt19937 rng;
+    ReplayCursor cursor; // positioned at the next turn after tick
+    // Nonzero when the state recurs every period ticks from here until the
+    // tick before until (ReplayLoop), so seeking can skip whole laps
+    uint64_t period{0};
+    uint64_t until{~0ull};
+};
+
+// Keyframes every `interval` ticks, built by simulating the replay once, so
+// seeking re-simulates at most interval ticks from the nearest one. Where
+// the game goes periodic one keyframe covers the laps (ReplayKeyframe::period)
+// and the simulation skips ahead, so a replay claiming a huge tick count
+// can't make the index huge.
+class ReplayIndex
+{
+public:
+    void build(const Replay &r, const Level &level, uint64_t interval = 1000);
+    bool empty() const { return frames.empty(); }
+    size_t size() const { return frames.size(); }
+
+    // Latest keyframe at or before tick
+    const ReplayKeyframe &at(uint64_t tick) const
+    {
+        auto k = std::upper_bound(frames.begin(), frames.end(), tick,
+                                  [](uint64_t t, const ReplayKeyframe &f)
+                                  { return t < f.tick; });
+        return k == frames.begin() ? frames.front() : *(k - 1);
+    }
+    // The tick at or before target with the same state as k, skipping laps
+    static uint64_t skip(const ReplayKeyframe &k, uint64_t target)
+    {
+        if (k.period == 0 || target <= k.tick)
+            return k.tick;
+        uint64_t last = std::min(target, k.until - 1);
+        return k.tick + (last - k.tick) / k.period * k.period;
+    }
+    // Put snake and fruit back into a keyframe's state
+    static void restore(const ReplayKeyframe &k, Snake &snake, Fruit &fruit);
+
+private:
+    std::vector<ReplayKeyframe> frames;
+};
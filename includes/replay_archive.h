@@ -0,0 +1,101 @@
+// Many replays in one file: entropy-coded turns, an offset table for O(1)
+// extraction, and a fixed-size index entry per replay for queries
+#pragma once
+#include "replay.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Everything in a ReplayHeader that varies; queries read only these
+struct ArchiveEntry
+{
+    uint64_t ticks;
+    uint64_t timeSec;
+    int32_t score;
+    uint32_t length;
+    uint32_t seed;
+    uint32_t turns;
+    int32_t width;
+    int32_t height;
+    int32_t tickMs;
+    uint32_t payloadBytes;
+    char name[24];
+    uint64_t level;     // ReplayHeader::level
+    uint32_t generator; // ReplayHeader::generator
+    uint32_t reserved;
+};
+static_assert(sizeof(ArchiveEntry) == 88, "ArchiveEntry is an on-disk layout");
+
+// Turn coding: each turn is a tick delta and a direction relative to the
+// previous one (left, right, or the rare reverse). An adaptive binary range
+// coder models the turn side on the previous two turns and the delta's bit
+// length on the previous delta's. Each replay starts from a fresh model, so
+// any one decodes alone.
+namespace turn_codec
+{
+    // Replay turn bytes (varints) to a coded payload appended to out; false
+    // if the bytes aren't exactly count varints
+    bool encode(const uint8_t *turns, size_t bytes, uint32_t count, std::vector<uint8_t> &out);
+    // Back to the varint turn bytes ReplayWriter produced, appended to out
+    bool decode(const uint8_t *payload, size_t bytes, uint32_t count, std::vector<uint8_t> &out);
+}
+
+// File layout: 64-byte header, payloads back to back, then the offset table
+// (count + 1 uint64 payload boundaries) and the index (count entries).
+// Written to a temporary file and renamed over `path` by finish().
+class ReplayArchiveWriter
+{
+public:
+    ReplayArchiveWriter() = default;
+    ~ReplayArchiveWriter();
+    ReplayArchiveWriter(const ReplayArchiveWriter &) = delete;
+    ReplayArchiveWriter &operator=(const ReplayArchiveWriter &) = delete;
+
+    bool open(const std::string &path);
+    // Append one replay; false (and nothing written) if its turns are damaged
+    bool add(const Replay &r);
+    // Write the tables and header; the archive is unusable until then
+    bool finish();
+
+    size_t size() const { return entries.size(); }
+    uint64_t rawTurnBytes() const { return rawBytes; }
+    uint64_t codedTurnBytes() const { return codedBytes; }
+
+private:
+    std::string path;
+    std::string tmpPath;
+    int fd{-1};
+    uint64_t offset{0};
+    std::vector<uint64_t> offsets;
+    std::vector<ArchiveEntry> entries;
+    std::vector<uint8_t> coded;
+    std::vector<uint8_t> check;
+    uint64_t rawBytes{0};
+    uint64_t codedBytes{0};
+};
+
+// An archive mapped read-only
+class ReplayArchive
+{
+public:
+    ReplayArchive() = default;
+    ~ReplayArchive() { close(); }
+    ReplayArchive(const ReplayArchive &) = delete;
+    ReplayArchive &operator=(const ReplayArchive &) = delete;
+
+    bool open(const std::string &path);
+    void close();
+
+    size_t size() const { return count; }
+    const ArchiveEntry &entry(size_t i) const { return entries[i]; }
+    // The original .bhr file bytes of replay i
+    bool extract(size_t i, std::vector<uint8_t> &file) const;
+
+private:
+    void *base{nullptr};
+    size_t mapSize{0};
+    size_t count{0};
+    const uint64_t *offsets{nullptr};
+    const ArchiveEntry *entries{nullptr};
+};
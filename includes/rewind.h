@@ -0,0 +1,57 @@
+// Bounded history of per-tick changes, for rewinding in practice mode
+#pragma once
+#include "point.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// What one tick changed. The new head needn't be stored: undoing the tick
+// just drops the snake's current head.
+struct TickDelta
+{
+    Point tail;  // removed from the back, unless the snake grew
+    Point fruit; // fruit position before the tick
+    int8_t scoreDelta;
+    uint8_t before; // Direction of the move before this tick's
+    uint8_t dir;    // Direction the tick moved in
+    uint8_t grew;
+};
+
+// The last `capacity` ticks; older ones fall off. Allocated once, so
+// recording is a single store per tick and memory doesn't depend on the
+// snake's length.
+class RewindBuffer
+{
+public:
+    explicit RewindBuffer(size_t capacity = 1024) : ring(capacity ? capacity : 1) {}
+
+    void clear()
+    {
+        next = 0;
+        count = 0;
+    }
+    size_t size() const { return count; }
+
+    void push(const TickDelta &d)
+    {
+        ring[next] = d;
+        next = (next + 1) % ring.size();
+        if (count < ring.size())
+            ++count;
+    }
+    // Newest first
+    bool pop(TickDelta &d)
+    {
+        if (count == 0)
+            return false;
+        next = (next + ring.size() - 1) % ring.size();
+        --count;
+        d = ring[next];
+        return true;
+    }
+
+private:
+    std::vector<TickDelta> ring;
+    size_t next{0};
+    size_t count{0};
+};
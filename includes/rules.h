@@ -0,0 +1,20 @@
+// Game rules for one tick, shared by Game::update and the replay tools
+#pragma once
+#include "fruit.h"
+#include "level.h"
+#include "snake.h"
+
+enum class StepResult
+{
+    Moved,
+    Grew,
+    HitWall,
+    HitSelf
+};
+
+inline bool isDeath(StepResult r) { return r == StepResult::HitWall || r == StepResult::HitSelf; }
+
+// Advance the snake one step on the level's board: a wall or the body ends
+// the game; the fruit scores 10, grows the snake and respawns off the snake
+// and the walls; otherwise the snake just moves. On death nothing changes.
+StepResult stepRules(const Level &level, Snake &snake, Fruit &fruit, int &score);
@@ -0,0 +1,35 @@
+// Suspended game on disk: a fixed header, the fruit generator state, then
+// the snake body head first as raw Points, so resuming is one read straight
+// into the snake's storage with nothing parsed per segment
+#pragma once
+#include "fruit.h"
+#include "level.h"
+#include "snake.h"
+#include <cstdint>
+#include <string>
+
+// Game state beside the snake and fruit
+struct SavedGame
+{
+    int32_t width{0}; // board the save belongs to
+    int32_t height{0};
+    uint64_t level{0}; // Level::id() of that board
+    int32_t score{0};
+    int32_t tickMs{0};
+    uint64_t tick{0};
+    uint32_t seed{0}; // Game::setSeed() value, reused on restart
+    bool seeded{false};
+    char name[24]{};
+};
+
+namespace save_game
+{
+    // Written beside path and renamed into place, so a crash leaves either
+    // the previous save or the new one
+    bool write(const std::string &path, const SavedGame &g, const Snake &snake, const Fruit &fruit);
+    // A save for another board than level, or a damaged or truncated file,
+    // is rejected and leaves g and fruit alone. The body is read straight
+    // into snake before its checksum and cells can be checked, so on false
+    // the caller resets the snake.
+    bool read(const std::string &path, const Level &level, SavedGame &g, Snake &snake, Fruit &fruit);
+}
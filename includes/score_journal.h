@@ -0,0 +1,89 @@
+// Score history: append-only journal of finished games, compacted into an
+// indexed snapshot in the background
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+
+// One finished game. Fixed 64 bytes so both files are flat arrays.
+struct GameRecord
+{
+    uint64_t timeSec;    // wall clock when the game ended
+    uint64_t durationMs; // game time played
+    uint64_t ticks;
+    int32_t score;
+    uint32_t length; // snake length at the end
+    uint32_t seed;   // fruit placement seed
+    uint32_t checksum; // over the rest of the record; detects a torn journal tail
+    char name[24];     // NUL-terminated, truncated to fit
+};
+static_assert(sizeof(GameRecord) == 64, "GameRecord is an on-disk layout");
+
+// Files: <base>.journal (64-byte header, then records in append order) and
+// <base>.snapshot (fixed header with the totals and top K, every record in
+// order, then a by-score index). Startup reads the snapshot header and the
+// journal, which compaction keeps below compactEvery records, so it costs
+// the same however many games have been played. Appends and compaction run
+// on a background thread; several instances may share the files.
+class ScoreJournal
+{
+public:
+    static constexpr int TopK = 10;
+
+    struct Summary
+    {
+        uint64_t games{0};
+        int topCount{0};
+        GameRecord top[TopK]{}; // best first
+    };
+
+    ScoreJournal() = default;
+    ~ScoreJournal() { close(); }
+    ScoreJournal(const ScoreJournal &) = delete;
+    ScoreJournal &operator=(const ScoreJournal &) = delete;
+
+    // Load the summary and start the writer thread
+    bool open(const std::string &base, uint32_t compactEvery = 4096);
+    // Write out queued records, then stop the writer thread
+    void close();
+    bool isOpen() const { return writer.joinable(); }
+
+    // Queue a finished game. Never blocks on I/O and never allocates; if
+    // the writer falls more than queueSize records behind, the record is
+    // dropped from the file (the in-memory summary still counts it).
+    void append(const GameRecord &r);
+
+    // Totals and top K, including games appended by this process (the
+    // game's side panel shows the count and best score)
+    const Summary &summary() const { return sum; }
+
+    // Fold the journal into the snapshot now (synchronous)
+    bool compact();
+
+    // Print totals, the top scores and the most recent games. The top list
+    // comes from the snapshot's by-score index, so it costs `top` reads
+    // however long the history is.
+    static bool dump(const std::string &base, std::ostream &out, size_t top = TopK, size_t recent = 10);
+
+private:
+    static constexpr int queueSize = 64;
+
+    void writerLoop();
+    bool writeBatch(const GameRecord *recs, int n, uint64_t &journalRecords);
+
+    std::string journalPath;
+    std::string snapshotPath;
+    uint32_t compactEvery{4096};
+    Summary sum;
+
+    std::thread writer;
+    std::mutex mu;
+    std::condition_variable cv;
+    GameRecord queue[queueSize];
+    int queued{0};
+    bool stopping{false};
+};
@@ -1,36 +1,127 @@
 #pragma once
-#include <deque>
+#include <cstddef>
+#include <vector>
 #include "point.h"
 
-enum class Direction
+// Snake segments, head first, in a power-of-two ring buffer. Once the
+// capacity covers the board, moving never allocates.
+class SnakeBody
 {
-    Up,
-    Down,
-    Left,
-    Right
+public:
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    size_t capacity() const { return buf.size(); }
+    // i = 0 is the head
+    const Point &operator[](size_t i) const { return buf[(first + i) & mask]; }
+    const Point &front() const { return buf[first]; }
+    const Point &back() const { return (*this)[count - 1]; }
+
+    void reserve(size_t n);
+    void clear()
+    {
+        first = 0;
+        count = 0;
+    }
+    void push_front(const Point &p)
+    {
+        if (count == buf.size())
+            reserve(count + 1);
+        first = (first - 1) & mask;
+        buf[first] = p;
+        ++count;
+    }
+    void push_back(const Point &p)
+    {
+        if (count == buf.size())
+            reserve(count + 1);
+        buf[(first + count) & mask] = p;
+        ++count;
+    }
+    void pop_back() { --count; }
+    void pop_front()
+    {
+        first = (first + 1) & mask;
+        --count;
+    }
+
+    // Bulk save: the segments as two contiguous runs, head first
+    void runs(const Point *&a, size_t &na, const Point *&b, size_t &nb) const
+    {
+        a = buf.data() + first;
+        na = count < buf.size() - first ? count : buf.size() - first;
+        b = buf.data();
+        nb = count - na;
+    }
+    // Bulk load: room for n segments, head first, to be filled by the caller
+    Point *assign(size_t n)
+    {
+        reserve(n);
+        first = 0;
+        count = n;
+        return buf.data();
+    }
+
+private:
+    std::vector<Point> buf;
+    size_t mask{0};
+    size_t first{0};
+    size_t count{0};
 };
 
 class Snake
 {
 public:
-    Snake(int startX, int startY, int initialLength = 3);
+    // capacity: segments to preallocate (e.g. board cells); grows if exceeded
+    Snake(int startX, int startY, int initialLength = 3, size_t capacity = 0);
+
+    // Back to a straight snake facing right, reusing the segment storage
+    void reset(int startX, int startY, int initialLength = 3);
+
+    // Bulk load (save files): storage for length segments, head first,
+    // heading d after a last move in `moved` (d unless a turn was pending)
+    Point *restore(size_t length, Direction d, Direction lastMoved)
+    {
+        dir = d;
+        moved = lastMoved;
+        return body.assign(length);
+    }
+    Point *restore(size_t length, Direction d) { return restore(length, d, d); }
 
     // Advance one step. If grow is true, don't remove tail.
-    void move(bool grow = false);
-    // Change direction if it's not directly opposite
+    void move(bool grow = false) { move(nextHead(), grow); }
+    // Same, onto newHead: the cell the board's topology leads to
+    void move(const Point &newHead, bool grow);
+    // Undo one move(): drop the head and put back the tail it removed (none
+    // if it grew), heading d again after a last move in lastMoved. O(1)
+    // whatever the length.
+    void unmove(const Point &tail, bool grew, Direction d, Direction lastMoved)
+    {
+        body.pop_front();
+        if (!grew)
+            body.push_back(tail);
+        dir = d;
+        moved = lastMoved;
+    }
+    // Change direction unless it's directly opposite the last move. Checking
+    // the move rather than the last key means two keys within one tick
+    // (Up then Left while heading Right) can't turn the head into the neck.
     void setDirection(Direction d);
     Direction getDirection() const { return dir; }
+    // Direction of the last move(), which setDirection() guards against
+    Direction lastMove() const { return moved; }
 
     const Point &head() const { return body.front(); }
-    const std::deque<Point> &segments() const { return body; }
+    const SnakeBody &segments() const { return body; }
 
     bool hitsSelf(const Point &nextHead) const;
     bool contains(const Point &p) const;
 
-    // Compute next head position given current direction
-    Point nextHead() const;
+    // The cell beside the head in the current direction, ignoring the
+    // board's topology (Level::step() applies it)
+    Point nextHead() const { return neighbour(body.front(), dir); }
 
 private:
-    std::deque<Point> body;
+    SnakeBody body;
     Direction dir;
+    Direction moved;
 };
@@ -0,0 +1,73 @@
+// Scoped trace spans exported as Chrome/Perfetto trace-event JSON
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+#ifndef BYTEHEBI_TRACE
+#define BYTEHEBI_TRACE 0
+#endif
+
+// Buffered background writer for "complete" (ph:X) events. Spans append to a
+// per-thread batch; full batches are handed to a writer thread that formats
+// and writes JSON, so the game loop never touches the file.
+namespace trace
+{
+    // Start writing events to path; returns false if the file can't be opened
+    bool start(const std::string &path);
+    // Flush outstanding batches, close the JSON array and join the writer.
+    // Call once traced threads are done emitting spans.
+    void stop();
+    bool enabled();
+    // name must outlive the trace (string literals)
+    void complete(const char *name, uint64_t startNs, uint64_t endNs);
+    inline uint64_t nowNs()
+    {
+        return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+}
+
+// Policies select the instrumentation at compile time
+struct NullTracePolicy
+{
+};
+
+struct ChromeTracePolicy
+{
+};
+
+template <typename Policy>
+class BasicTraceSpan;
+
+// Compiled out: an empty object with trivial constructor and destructor
+template <>
+class BasicTraceSpan<NullTracePolicy>
+{
+public:
+    explicit BasicTraceSpan(const char *) {}
+};
+
+template <>
+class BasicTraceSpan<ChromeTracePolicy>
+{
+public:
+    explicit BasicTraceSpan(const char *name) : name(name), start(trace::nowNs()) {}
+    ~BasicTraceSpan() { trace::complete(name, start, trace::nowNs()); }
+    BasicTraceSpan(const BasicTraceSpan &) = delete;
+    BasicTraceSpan &operator=(const BasicTraceSpan &) = delete;
+
+private:
+    const char *name;
+    uint64_t start;
+};
+
+#if BYTEHEBI_TRACE
+using ActiveTracePolicy = ChromeTracePolicy;
+#else
+using ActiveTracePolicy = NullTracePolicy;
+#endif
+
+// Usage: TraceSpan span("Game::update");
+using TraceSpan = BasicTraceSpan<ActiveTracePolicy>;
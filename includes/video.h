@@ -0,0 +1,52 @@
+// Software rasterizer for headless video export (Y4M stream, PPM images)
+#pragma once
+#include "level.h"
+#include "point.h"
+#include "snake.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// What one video frame shows
+struct VideoFrame
+{
+    uint64_t tick{0};
+    std::vector<Point> body; // head first
+    Direction dir{Direction::Right};
+    Point fruit{0, 0};
+};
+
+enum class VideoFormat
+{
+    Y4M, // "FRAME\n" and 4:2:0 BT.601 planes, after y4mHeader()
+    PPM  // a complete binary P6 image
+};
+
+// Draws the board at cellPx pixels per cell in the game's colours
+// (palette.h): the level's walls in the border gradient, grid dots, the fruit, and the
+// snake in its head-to-tail gradient. The walls and grid are drawn once;
+// a frame copies them and draws the snake and fruit on top. encode() is
+// const, so frames can be rendered on several threads at once.
+class FrameRasterizer
+{
+public:
+    FrameRasterizer(const Level &level, int cellPx);
+
+    int pixelWidth() const { return pw; }
+    int pixelHeight() const { return ph; }
+
+    // Stream header for Y4M output, frame rate fpsNum/fpsDen
+    std::string y4mHeader(int fpsNum, int fpsDen) const;
+
+    // Encode f into out (replacing its contents). rgb is per-thread scratch.
+    void encode(const VideoFrame &f, VideoFormat format, std::vector<uint8_t> &rgb, std::vector<uint8_t> &out) const;
+
+private:
+    void draw(const VideoFrame &f, uint8_t *rgb) const;
+    void fillRect(uint8_t *rgb, int x0, int y0, int x1, int y1, uint8_t r, uint8_t g, uint8_t b) const;
+
+    int width, height, cell;
+    int pw, ph;
+    std::vector<uint8_t> background; // RGB, walls and grid
+};
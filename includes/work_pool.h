@@ -0,0 +1,96 @@
+// Parallel loop over independent jobs of uneven cost, with work stealing
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Each worker starts with an equal slice of [0, n) and takes jobs from its
+// front; a worker that runs dry steals the back half of another's slice. A
+// slice's lock is only contended while it is being stolen from, so this is
+// meant for jobs well above a microsecond (a replay, a video frame).
+class WorkPool
+{
+public:
+    // 0 threads = one per hardware thread
+    explicit WorkPool(unsigned threads = 0)
+        : count(threads ? threads : std::max(1u, std::thread::hardware_concurrency()))
+    {
+    }
+
+    unsigned threads() const { return count; }
+
+    // Call fn(job, worker) once for every job in [0, n); returns when all are
+    // done. worker is in [0, threads()), for per-worker scratch state.
+    template <typename Fn>
+    void run(size_t n, Fn &&fn)
+    {
+        unsigned workers = (unsigned)std::min<size_t>(count, std::max<size_t>(n, 1));
+        std::unique_ptr<Slice[]> slices(new Slice[workers]);
+        for (unsigned w = 0; w < workers; ++w)
+        {
+            slices[w].next = n * w / workers;
+            slices[w].end = n * (w + 1) / workers;
+        }
+
+        auto work = [&](unsigned w)
+        {
+            size_t job;
+            while (take(slices[w], job) || steal(slices.get(), workers, w, job))
+                fn(job, w);
+        };
+        std::vector<std::thread> pool;
+        pool.reserve(workers - 1);
+        for (unsigned w = 1; w < workers; ++w)
+            pool.emplace_back(work, w);
+        work(0);
+        for (std::thread &t : pool)
+            t.join();
+    }
+
+private:
+    struct alignas(64) Slice
+    {
+        std::mutex mu;
+        size_t next{0};
+        size_t end{0};
+    };
+
+    static bool take(Slice &s, size_t &job)
+    {
+        std::lock_guard<std::mutex> lock(s.mu);
+        if (s.next == s.end)
+            return false;
+        job = s.next++;
+        return true;
+    }
+
+    // Run the first stolen job now and leave the rest in our own slice
+    static bool steal(Slice *slices, unsigned workers, unsigned self, size_t &job)
+    {
+        for (unsigned k = 1; k < workers; ++k)
+        {
+            Slice &victim = slices[(self + k) % workers];
+            size_t from, to;
+            {
+                std::lock_guard<std::mutex> lock(victim.mu);
+                if (victim.next == victim.end)
+                    continue;
+                from = victim.next + (victim.end - victim.next) / 2;
+                to = victim.end;
+                victim.end = from;
+            }
+            Slice &own = slices[self];
+            std::lock_guard<std::mutex> lock(own.mu);
+            job = from;
+            own.next = from + 1;
+            own.end = to;
+            return true;
+        }
+        return false;
+    }
+
+    unsigned count;
+};
@@ -0,0 +1,380 @@
+// Asciicast v2 writer: stream relay, frame marks, JSON event formatting
+#include "asciicast.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace
+{
+    // Private APC sequence carrying a frame time; terminals ignore APC, and
+    // the relay strips these before anything else sees the stream
+    constexpr char kMark[] = "\x1b_BHCAST;";
+    constexpr size_t kMarkLen = sizeof kMark - 1;
+    constexpr char kMarkEnd[] = "\x1b\\";
+
+    void writeAll(int fd, const char *p, size_t n)
+    {
+        while (n)
+        {
+            ssize_t w = ::write(fd, p, n);
+            if (w < 0 && errno == EINTR)
+                continue;
+            if (w <= 0)
+                return;
+            p += w;
+            n -= (size_t)w;
+        }
+    }
+
+    // Length of a valid UTF-8 sequence at p, or 0
+    size_t utf8Length(const unsigned char *p, const unsigned char *end)
+    {
+        unsigned char c = p[0];
+        size_t n;
+        unsigned char lo = 0x80, hi = 0xBF; // allowed range of the second byte
+        if (c >= 0xC2 && c <= 0xDF)
+            n = 2;
+        else if (c >= 0xE0 && c <= 0xEF)
+        {
+            n = 3;
+            if (c == 0xE0)
+                lo = 0xA0;
+            else if (c == 0xED)
+                hi = 0x9F;
+        }
+        else if (c >= 0xF0 && c <= 0xF4)
+        {
+            n = 4;
+            if (c == 0xF0)
+                lo = 0x90;
+            else if (c == 0xF4)
+                hi = 0x8F;
+        }
+        else
+            return 0;
+        if ((size_t)(end - p) < n || p[1] < lo || p[1] > hi)
+            return 0;
+        for (size_t i = 2; i < n; ++i)
+            if ((p[i] & 0xC0) != 0x80)
+                return 0;
+        return n;
+    }
+
+    // Terminal output as a JSON string body; invalid UTF-8 becomes U+FFFD
+    void appendJson(std::string &s, const char *data, size_t n)
+    {
+        const unsigned char *p = reinterpret_cast<const unsigned char *>(data);
+        const unsigned char *end = p + n;
+        while (p < end)
+        {
+            unsigned char c = *p;
+            if (c >= 0x80)
+            {
+                size_t len = utf8Length(p, end);
+                if (len)
+                    s.append(reinterpret_cast<const char *>(p), len);
+                else
+                    s += "\\ufffd";
+                p += len ? len : 1;
+                continue;
+            }
+            switch (c)
+            {
+            case '"':
+                s += "\\\"";
+                break;
+            case '\\':
+                s += "\\\\";
+                break;
+            case '\n':
+                s += "\\n";
+                break;
+            case '\r':
+                s += "\\r";
+                break;
+            case '\t':
+                s += "\\t";
+                break;
+            default:
+                if (c < 0x20)
+                {
+                    char esc[8];
+                    std::snprintf(esc, sizeof esc, "\\u%04x", c);
+                    s += esc;
+                }
+                else
+                    s += (char)c;
+            }
+            ++p;
+        }
+    }
+}
+
+bool AsciicastRecorder::open(const std::string &path, unsigned c, unsigned r)
+{
+    close();
+    out = std::fopen(path.c_str(), "w");
+    if (!out)
+        return false;
+    cols = c;
+    rows = r;
+    return true;
+}
+
+FILE *AsciicastRecorder::tee(int fd)
+{
+    if (!out || stream)
+        return nullptr;
+    int fds[2];
+    if (pipe2(fds, O_CLOEXEC) != 0)
+        return nullptr;
+    // Room for a full redraw of a large terminal, so Notcurses rarely waits
+    // on the relay
+    fcntl(fds[1], F_SETPIPE_SZ, 1 << 20);
+    stream = fdopen(fds[1], "w");
+    if (!stream)
+    {
+        ::close(fds[0]);
+        ::close(fds[1]);
+        return nullptr;
+    }
+    streamFd = fds[1];
+    readFd = fds[0];
+    terminalFd = fd;
+    writer = std::thread(&AsciicastRecorder::writerLoop, this);
+    relay = std::thread(&AsciicastRecorder::relayLoop, this);
+    return stream;
+}
+
+FILE *AsciicastRecorder::offscreen()
+{
+    if (!out || stream)
+        return nullptr;
+    // No terminal to ask: a fixed, common terminal type
+    setenv("TERM", "xterm-256color", 1);
+    if (!pty.open(rows, cols))
+    {
+        pty.close();
+        return nullptr;
+    }
+    int fd = dup(pty.slave);
+    stream = fd >= 0 ? fdopen(fd, "w") : nullptr;
+    if (!stream)
+    {
+        if (fd >= 0)
+            ::close(fd);
+        pty.close();
+        return nullptr;
+    }
+    streamFd = fd;
+    readFd = pty.master;
+    savedStdin = dup(STDIN_FILENO);
+    dup2(pty.slave, STDIN_FILENO);
+    writer = std::thread(&AsciicastRecorder::writerLoop, this);
+    relay = std::thread(&AsciicastRecorder::relayLoop, this);
+    return stream;
+}
+
+void AsciicastRecorder::frame(uint64_t timeNs)
+{
+    if (!stream)
+        return;
+    // Fixed buffer: this runs every frame
+    char mark[48];
+    int n = std::snprintf(mark, sizeof mark, "%s%llu%s", kMark, (unsigned long long)timeNs, kMarkEnd);
+    std::fflush(stream);
+    writeAll(streamFd, mark, (size_t)n);
+}
+
+void AsciicastRecorder::relayLoop()
+{
+    std::vector<char> buf(64 * 1024);
+    pending.reserve(1 << 20);
+    for (;;)
+    {
+        ssize_t n = ::read(readFd, buf.data(), buf.size());
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            break; // writer side closed (EOF on the pipe, EIO on the pty)
+        if (pty.master >= 0)
+            responder.scan(pty.master, buf.data(), (size_t)n);
+        scan(buf.data(), (size_t)n);
+    }
+    // An unfinished mark at the very end was just output
+    if (!markTail.empty())
+    {
+        std::string rest;
+        rest.swap(markTail);
+        if (terminalFd >= 0)
+            writeAll(terminalFd, rest.data(), rest.size());
+        pending.insert(pending.end(), rest.begin(), rest.end());
+    }
+}
+
+void AsciicastRecorder::scan(const char *p, size_t n)
+{
+    std::string data;
+    data.reserve(markTail.size() + n);
+    data.swap(markTail);
+    data.append(p, n);
+
+    size_t pos = 0;
+    while (pos < data.size())
+    {
+        size_t mark = data.find(kMark, pos, kMarkLen);
+        size_t plain = mark == std::string::npos ? data.size() : mark;
+        if (mark == std::string::npos)
+        {
+            // Hold back a suffix that could be the start of a split mark
+            size_t keep = std::min(kMarkLen - 1, data.size() - pos);
+            while (keep && data.compare(data.size() - keep, keep, kMark, keep) != 0)
+                --keep;
+            plain = data.size() - keep;
+        }
+        if (plain > pos)
+        {
+            if (terminalFd >= 0)
+                writeAll(terminalFd, data.data() + pos, plain - pos);
+            pending.insert(pending.end(), data.begin() + (std::ptrdiff_t)pos, data.begin() + (std::ptrdiff_t)plain);
+        }
+        if (mark == std::string::npos)
+        {
+            markTail.assign(data, plain, std::string::npos);
+            return;
+        }
+        size_t end = data.find(kMarkEnd, mark + kMarkLen);
+        if (end == std::string::npos)
+        {
+            markTail.assign(data, mark, std::string::npos);
+            return;
+        }
+        cut(std::strtoull(data.c_str() + mark + kMarkLen, nullptr, 10));
+        pos = end + 2;
+    }
+}
+
+void AsciicastRecorder::cut(uint64_t timeNs)
+{
+    if (!haveOrigin)
+    {
+        origin = timeNs;
+        haveOrigin = true;
+    }
+    lastMark = timeNs;
+    if (pending.empty())
+        return;
+    uint64_t t = timeNs >= origin ? timeNs - origin : 0;
+    uint32_t size = (uint32_t)pending.size();
+    {
+        std::lock_guard<std::mutex> lock(mu);
+        if (queue.size() + sizeof t + sizeof size + size > bufferBytes)
+            dropped.fetch_add(size, std::memory_order_relaxed);
+        else
+        {
+            const char *tp = reinterpret_cast<const char *>(&t);
+            const char *sp = reinterpret_cast<const char *>(&size);
+            queue.insert(queue.end(), tp, tp + sizeof t);
+            queue.insert(queue.end(), sp, sp + sizeof size);
+            queue.insert(queue.end(), pending.begin(), pending.end());
+        }
+    }
+    cv.notify_one();
+    pending.clear();
+}
+
+void AsciicastRecorder::writerLoop()
+{
+    const char *term = std::getenv("TERM");
+    std::fprintf(out,
+                 "{\"version\": 2, \"width\": %u, \"height\": %u, \"timestamp\": %lld, "
+                 "\"title\": \"ByteHebi\", \"env\": {\"TERM\": \"%s\"}}\n",
+                 cols, rows, (long long)std::time(nullptr), term ? term : "");
+
+    std::vector<char> batch;
+    std::string line;
+    batch.reserve(bufferBytes);
+    queue.reserve(bufferBytes);
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mu);
+            cv.wait(lock, [&]
+                    { return stopping || !queue.empty(); });
+            if (queue.empty())
+                break;
+            batch.swap(queue);
+        }
+        for (size_t i = 0; i + 12 <= batch.size();)
+        {
+            uint64_t t;
+            uint32_t size;
+            std::memcpy(&t, batch.data() + i, sizeof t);
+            std::memcpy(&size, batch.data() + i + sizeof t, sizeof size);
+            i += sizeof t + sizeof size;
+            char stamp[40];
+            std::snprintf(stamp, sizeof stamp, "[%llu.%06llu, \"o\", \"", (unsigned long long)(t / 1000000000ull),
+                          (unsigned long long)(t % 1000000000ull / 1000));
+            line.assign(stamp);
+            appendJson(line, batch.data() + i, size);
+            line += "\"]\n";
+            std::fwrite(line.data(), 1, line.size(), out);
+            i += size;
+        }
+        batch.clear();
+    }
+}
+
+void AsciicastRecorder::close()
+{
+    if (stream)
+    {
+        std::fclose(stream);
+        stream = nullptr;
+        streamFd = -1;
+        if (savedStdin >= 0)
+        {
+            dup2(savedStdin, STDIN_FILENO);
+            ::close(savedStdin);
+            savedStdin = -1;
+        }
+        // Last slave reference gone: the relay drains the pty and stops
+        if (pty.slave >= 0)
+        {
+            ::close(pty.slave);
+            pty.slave = -1;
+        }
+        if (relay.joinable())
+            relay.join();
+        // Whatever followed the last mark (Notcurses' shutdown sequences)
+        cut(lastMark);
+        if (readFd >= 0 && readFd != pty.master)
+            ::close(readFd);
+        readFd = -1;
+        pty.close();
+        {
+            std::lock_guard<std::mutex> lock(mu);
+            stopping = true;
+        }
+        cv.notify_one();
+        if (writer.joinable())
+            writer.join();
+    }
+    if (out)
+    {
+        std::fclose(out);
+        out = nullptr;
+    }
+    pending.clear();
+    markTail.clear();
+    queue.clear();
+    haveOrigin = false;
+    origin = lastMark = 0;
+    stopping = false;
+    terminalFd = -1;
+}
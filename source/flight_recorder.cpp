@@ -0,0 +1,238 @@
+// Flight recorder ring and fatal-signal terminal restore
+#include "flight_recorder.h"
+#include <csignal>
+#include <cstring>
+#include <iomanip>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <termios.h>
+#include <unistd.h>
+
+namespace
+{
+    constexpr char kMagic[8] = {'B', 'H', 'F', 'L', 'I', 'G', 'H', 'T'};
+    constexpr uint32_t kVersion = 1;
+
+    // Open path and take its lock, or -1 if another process holds it
+    int openLocked(const std::string &path)
+    {
+        int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        if (fd < 0)
+            return -1;
+        if (flock(fd, LOCK_EX | LOCK_NB) != 0)
+        {
+            ::close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+    struct Header
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t recordSize;
+        uint32_t capacity;
+        uint32_t pad;
+        uint64_t next; // total records written; slot = index & (capacity - 1)
+        uint8_t reserved[32];
+    };
+    static_assert(sizeof(Header) == 64, "header is an on-disk layout");
+}
+
+bool FlightRecorder::open(const std::string &path, uint32_t capacity)
+{
+    close();
+    uint64_t cap = 1;
+    while (cap < capacity)
+        cap <<= 1;
+    size_t size = sizeof(Header) + cap * sizeof(FlightRecord);
+
+    // Truncate only once the lock is ours: a second instance on the same
+    // file would otherwise wipe and interleave the first one's ring
+    std::string file = path;
+    int fd = openLocked(file);
+    if (fd < 0)
+    {
+        file = path + "." + std::to_string(getpid());
+        fd = openLocked(file);
+    }
+    if (fd < 0)
+        return false;
+    if (ftruncate(fd, 0) != 0 || ftruncate(fd, (off_t)size) != 0)
+    {
+        ::close(fd);
+        return false;
+    }
+    void *p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (p == MAP_FAILED)
+    {
+        ::close(fd);
+        return false;
+    }
+
+    Header *h = static_cast<Header *>(p);
+    std::memcpy(h->magic, kMagic, sizeof kMagic);
+    h->version = kVersion;
+    h->recordSize = sizeof(FlightRecord);
+    h->capacity = (uint32_t)cap;
+    h->next = 0;
+
+    base = p;
+    mapSize = size;
+    lockFd = fd;
+    if (file != path)
+        fallback = file;
+    slots = reinterpret_cast<FlightRecord *>(static_cast<char *>(p) + sizeof(Header));
+    nextInFile = &h->next;
+    next = 0;
+    mask = cap - 1;
+    return true;
+}
+
+void FlightRecorder::close()
+{
+    if (!base)
+        return;
+    msync(base, mapSize, MS_ASYNC);
+    munmap(base, mapSize);
+    // Unlink while the lock is still held, so nobody opens it in between
+    if (!fallback.empty())
+        ::unlink(fallback.c_str());
+    fallback.clear();
+    ::close(lockFd);
+    lockFd = -1;
+    base = nullptr;
+    slots = nullptr;
+    nextInFile = nullptr;
+    mapSize = 0;
+}
+
+void FlightRecorder::flush() const
+{
+    if (base)
+        msync(base, mapSize, MS_SYNC);
+}
+
+bool FlightRecorder::dump(const std::string &path, std::ostream &out)
+{
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat st
+    {
+    };
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(Header))
+    {
+        ::close(fd);
+        return false;
+    }
+    void *p = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED)
+        return false;
+    const Header *h = static_cast<const Header *>(p);
+    bool ok = std::memcmp(h->magic, kMagic, sizeof kMagic) == 0 && h->version == kVersion &&
+              h->recordSize == sizeof(FlightRecord) && h->capacity != 0 &&
+              (size_t)st.st_size >= sizeof(Header) + (size_t)h->capacity * sizeof(FlightRecord);
+    if (ok)
+    {
+        static const char *dirs[] = {"up", "down", "left", "right"};
+        const FlightRecord *recs = reinterpret_cast<const FlightRecord *>(h + 1);
+        uint64_t end = h->next;
+        uint64_t begin = end > h->capacity ? end - h->capacity : 0;
+        out << "# " << (end - begin) << " of " << end << " records\n"
+            << "#        tick       time_ms  frame_us        key   head  dir   flags\n";
+        for (uint64_t i = begin; i < end; ++i)
+        {
+            const FlightRecord &r = recs[i & (h->capacity - 1)];
+            out << std::setw(13) << r.tick
+                << std::setw(14) << std::fixed << std::setprecision(3) << (double)r.timeNs / 1e6
+                << std::setw(10) << r.frameNs / 1000
+                << std::setw(11) << std::hex << std::showbase << r.key << std::dec << std::noshowbase
+                << std::setw(4) << r.headX << "," << std::left << std::setw(3) << r.headY << std::right
+                << std::setw(5) << (r.dir < 4 ? dirs[r.dir] : "?")
+                << ((r.flags & FlightRecord::Grew) ? "  grew" : "")
+                << ((r.flags & FlightRecord::Died) ? "  died" : "") << "\n";
+        }
+    }
+    munmap(p, (size_t)st.st_size);
+    return ok;
+}
+
+namespace
+{
+    const int kSignals[] = {SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT, SIGTERM, SIGINT, SIGHUP, SIGQUIT};
+    constexpr int kSignalCount = sizeof(kSignals) / sizeof(kSignals[0]);
+
+    struct sigaction g_prev[kSignalCount];
+    bool g_installed = false;
+    const FlightRecorder *g_recorder = nullptr;
+    struct termios g_termios;
+    bool g_haveTermios = false;
+    // Own stack so a stack overflow SIGSEGV can still be handled
+    alignas(16) char g_altStack[64 * 1024];
+
+    void onFatal(int sig)
+    {
+        if (g_recorder)
+            g_recorder->flush();
+        // Only async-signal-safe calls from here: write(2) and tcsetattr(3)
+        static const char reset[] = "\x1b[0m\x1b[?25h\x1b[?1049l\r\n";
+        ssize_t w = write(STDOUT_FILENO, reset, sizeof reset - 1);
+        (void)w;
+        if (g_haveTermios)
+            tcsetattr(STDIN_FILENO, TCSANOW, &g_termios);
+        // Hand over to the previous disposition (Notcurses' own handler or
+        // the default action) and re-deliver
+        for (int i = 0; i < kSignalCount; ++i)
+        {
+            if (kSignals[i] == sig)
+            {
+                sigaction(sig, &g_prev[i], nullptr);
+                break;
+            }
+        }
+        raise(sig);
+    }
+}
+
+namespace crash_guard
+{
+    void saveTerminal()
+    {
+        g_haveTermios = tcgetattr(STDIN_FILENO, &g_termios) == 0;
+    }
+
+    void install(const FlightRecorder *recorder)
+    {
+        g_recorder = recorder;
+        if (g_installed)
+            return;
+        stack_t ss{};
+        ss.ss_sp = g_altStack;
+        ss.ss_size = sizeof g_altStack;
+        sigaltstack(&ss, nullptr);
+
+        struct sigaction sa{};
+        sa.sa_handler = onFatal;
+        sigemptyset(&sa.sa_mask);
+        sa.sa_flags = SA_ONSTACK;
+        for (int i = 0; i < kSignalCount; ++i)
+            sigaction(kSignals[i], &sa, &g_prev[i]);
+        g_installed = true;
+    }
+
+    void uninstall()
+    {
+        if (!g_installed)
+            return;
+        for (int i = 0; i < kSignalCount; ++i)
+            sigaction(kSignals[i], &g_prev[i], nullptr);
+        g_installed = false;
+        g_recorder = nullptr;
+    }
+}
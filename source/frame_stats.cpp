@@ -0,0 +1,155 @@
+// Frame timing histograms
+#include "frame_stats.h"
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+
+int LatencyHistogram::bucketOf(uint64_t v)
+{
+    if (v < 2 * (uint64_t)subCount)
+        return (int)v;
+    int msb = 63 - __builtin_clzll(v);
+    int shift = msb - subBits;
+    if (shift > maxShift)
+        return bucketCount - 1;
+    return shift * subCount + (int)(v >> shift);
+}
+
+uint64_t LatencyHistogram::bucketHigh(int idx)
+{
+    if (idx < 2 * subCount)
+        return (uint64_t)idx;
+    int shift = idx / subCount - 1;
+    uint64_t sub = (uint64_t)(idx % subCount + subCount);
+    return ((sub + 1) << shift) - 1;
+}
+
+void LatencyHistogram::record(uint64_t ns)
+{
+    ++counts[bucketOf(ns)];
+    ++total;
+    sum += ns;
+    if (ns > maxValue)
+        maxValue = ns;
+}
+
+void LatencyHistogram::clear()
+{
+    counts.fill(0);
+    total = sum = maxValue = 0;
+}
+
+uint64_t LatencyHistogram::percentile(double q) const
+{
+    if (total == 0)
+        return 0;
+    uint64_t want = (uint64_t)std::ceil(q * (double)total);
+    if (want == 0)
+        want = 1;
+    uint64_t seen = 0;
+    for (int i = 0; i < bucketCount; ++i)
+    {
+        seen += counts[i];
+        if (seen >= want)
+            return std::min(bucketHigh(i), maxValue);
+    }
+    return maxValue;
+}
+
+void LatencyHistogram::dump(std::ostream &out, const char *label) const
+{
+    out << "# " << label << " (ns)\n";
+    out << std::setw(12) << "Value" << std::setw(15) << "Percentile"
+        << std::setw(11) << "TotalCount" << std::setw(17) << "1/(1-Percentile)" << "\n\n";
+    uint64_t seen = 0;
+    out << std::fixed;
+    for (int i = 0; i < bucketCount; ++i)
+    {
+        if (counts[i] == 0)
+            continue;
+        seen += counts[i];
+        double p = (double)seen / (double)total;
+        out << std::setw(12) << std::min(bucketHigh(i), maxValue)
+            << std::setw(15) << std::setprecision(12) << p
+            << std::setw(11) << seen;
+        if (seen < total)
+            out << std::setw(17) << std::setprecision(2) << 1.0 / (1.0 - p);
+        out << "\n";
+    }
+    out << std::setprecision(3)
+        << "#[Mean    = " << std::setw(12) << mean() << ", Max = " << maxValue << "]\n"
+        << "#[Total count = " << total << "]\n\n";
+    out.unsetf(std::ios::fixed);
+}
+
+void SampleWindow::push(uint64_t ns)
+{
+    samples[head] = ns;
+    head = (head + 1) % size;
+    if (n < size)
+        ++n;
+}
+
+uint64_t SampleWindow::percentile(double q) const
+{
+    if (n == 0)
+        return 0;
+    std::array<uint64_t, size> tmp;
+    for (int i = 0; i < n; ++i)
+        tmp[i] = recent(i);
+    int k = std::min(n - 1, (int)(q * (double)n));
+    std::nth_element(tmp.begin(), tmp.begin() + k, tmp.begin() + n);
+    return tmp[k];
+}
+
+uint64_t SampleWindow::max() const
+{
+    uint64_t m = 0;
+    for (int i = 0; i < n; ++i)
+        m = std::max(m, recent(i));
+    return m;
+}
+
+const char *FrameStats::phaseName(Phase p)
+{
+    switch (p)
+    {
+    case Input:
+        return "processInput";
+    case Update:
+        return "update";
+    case Render:
+        return "render";
+    case NcRender:
+        return "notcurses_render";
+    case Frame:
+        return "frame";
+    default:
+        return "?";
+    }
+}
+
+void FrameStats::frameDone(uint64_t nowNs, uint32_t ticks)
+{
+    if (!rateStarted)
+    {
+        rateStart = nowNs;
+        rateStarted = true;
+    }
+    ++rateFrames;
+    rateTicks += ticks;
+    uint64_t span = nowNs - rateStart;
+    if (span >= 1000000000ull)
+    {
+        ticksPerSec = (double)rateTicks * 1e9 / (double)span;
+        framesPerSec = (double)rateFrames * 1e9 / (double)span;
+        rateStart = nowNs;
+        rateTicks = rateFrames = 0;
+    }
+}
+
+void FrameStats::dump(std::ostream &out) const
+{
+    for (int p = 0; p < PhaseCount; ++p)
+        hist[p].dump(out, phaseName((Phase)p));
+}
@@ -3,8 +3,18 @@
 
 Fruit::Fruit(int width, int height)
     : width(width), height(height)
+{
+    reseed();
+}
+
+void Fruit::reseed()
 {
     auto seed = static_cast<unsigned>(
         std::chrono::high_resolution_clock::now().time_since_epoch().count());
-    rng.seed(seed);
+    reseed(seed);
+}
+
+Fruit::Fruit(int width, int height, unsigned seed)
+    : width(width), height(height), rng(seed), currentSeed(seed)
+{
 }
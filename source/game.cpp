@@ -1,14 +1,23 @@
 // Snake game using Notcurses for rendering and input (Linux-only)
 #include "game.h"
+#include "trace.h"
+#include "metrics.h"
+#include "save_game.h"
+#include "rules.h"
+#include "palette.h"
 #include <fstream>
 #include <chrono>
-#include <thread>
 #include <algorithm>
 #include <clocale>
 #include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
 
 // Linux: Notcurses
 #include <notcurses/notcurses.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
 #include <unistd.h>
 
 // Globals & small helpers
@@ -18,107 +27,324 @@ namespace
     static notcurses *g_nc = nullptr;
     static ncplane *g_stdp = nullptr;
     inline void set_fg(ncplane *n, uint8_t r, uint8_t g, uint8_t b) { ncplane_set_fg_rgb8(n, r, g, b); }
+    inline uint64_t ns(Clock::duration d) { return (uint64_t)d.count(); }
+
+    // Right-aligned 5-column microsecond figure: "  123", " 45k" (ms), " 12M" (s)
+    void fmt_us(char *buf, size_t n, uint64_t nanos)
+    {
+        unsigned long long us = nanos / 1000;
+        if (us < 10000)
+            snprintf(buf, n, "%5llu", us);
+        else if (us < 10000000)
+            snprintf(buf, n, "%4lluk", us / 1000);
+        else
+            snprintf(buf, n, "%4lluM", us / 1000000);
+    }
 }
 
 // Game lifecycle
 
 Game::Game(int width, int height, const std::string &name)
     : width(width), height(height),
-      snake(width / 2, height / 2, 3),
+      level(Level::rectangle(width, height)),
+      snake(level.spawn().x, level.spawn().y, 3, (size_t)width * (size_t)height),
       fruit(width, height),
       playerName(name)
 {
-    loadHighScore();
+    // Name entry grows one key at a time; keep it off the heap mid-game
+    nameEntry.reserve(nameMaxLen);
     chooseDifficulty();
     // Ensure fruit not on snake at start
     fruit.respawn([&](const Point &p)
-                  { return snake.contains(p); });
+                  { return snake.contains(p) || level.wall(p); });
 }
 
 Game::~Game()
 {
-    saveHighScore();
+    // Quitting mid-run still ranks the score reached so far. Exit may wait
+    // briefly for another instance's update, unlike the game loop.
+    if (!over && tick > 0 && !suspended)
+    {
+        recordGame();
+        if (score > 0)
+            pendingScore = score;
+    }
+    for (int i = 0; i < 100 && pendingScore >= 0; ++i)
+    {
+        submitScore();
+        if (pendingScore >= 0)
+            usleep(1000);
+    }
 }
 
 int Game::run()
 {
-    // Initialize Notcurses
-    setlocale(LC_ALL, "");
-    notcurses_options opts{}; // defaults
-    struct notcurses *nc = notcurses_init(&opts, nullptr);
-    if (!nc)
+    if (!clock)
     {
-        return 1;
+        ownedClock = std::make_unique<SteadyClock>();
+        clock = ownedClock.get();
     }
-    ncplane *stdp = notcurses_stdplane(nc);
-    g_nc = nc;
-    g_stdp = stdp;
-
-    // Make sure our target area fits in the terminal
-    unsigned termh = 0, termw = 0;
-    ncplane_dim_yx(stdp, &termh, &termw);
-    // Adaptive sizing: prefer double-width cells, fall back to single-width if needed.
-    const int HUDW_CHECK = 24;                      // keep in sync with render()
-    const int boardTW_double = 2 * (width - 1) + 1; // xscale=2
-    const int boardTW_single = width;               // xscale=1
-    // Fatal only if even single-width cannot fit, or height cannot fit
-    if ((int)height > (int)termh || (boardTW_single + 1 + HUDW_CHECK) > (int)termw)
-    {
-        ncplane_putstr_yx(stdp, 0, 0, "Terminal too small for configured game size.");
-        std::string hint = std::string("Need at least ") + std::to_string(height) + " rows x " + std::to_string(boardTW_single + 1 + HUDW_CHECK) + " cols.";
-        ncplane_putstr_yx(stdp, 1, 0, hint.c_str());
-        notcurses_render(nc);
-        notcurses_stop(nc);
-        return 1;
+
+    if (!flightFile.empty())
+        recorder.open(flightFile);
+    if (!leaderboard.isOpen() && !leaderboardFile.empty())
+        setLeaderboardFile(leaderboardFile);
+    if (!journal.isOpen() && !historyBase.empty())
+        setHistoryFile(historyBase);
+
+    struct notcurses *nc = nullptr;
+    if (!headless)
+    {
+        // Initialize Notcurses
+        setlocale(LC_ALL, "");
+        crash_guard::saveTerminal();
+        notcurses_options opts{}; // defaults
+        FILE *ncOut = nullptr;
+        if (!castFile.empty())
+        {
+            // Offscreen: just wide enough for double-width cells and the HUD
+            unsigned cols = (unsigned)(2 * (width - 1) + 1 + 1 + 24), rows = (unsigned)height;
+            struct winsize ws{};
+            if (!castOffscreen && ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) == 0 && ws.ws_col && ws.ws_row)
+            {
+                cols = ws.ws_col;
+                rows = ws.ws_row;
+            }
+            if (cast.open(castFile, cols, rows))
+                ncOut = castOffscreen ? cast.offscreen() : cast.tee(STDOUT_FILENO);
+            if (!ncOut)
+                return 1;
+            if (castOffscreen)
+                opts.flags = NCOPTION_SUPPRESS_BANNERS | NCOPTION_NO_QUIT_SIGHANDLERS |
+                             NCOPTION_NO_WINCH_SIGHANDLER | NCOPTION_INHIBIT_SETLOCALE;
+        }
+        nc = notcurses_init(&opts, ncOut);
+        if (!nc)
+        {
+            cast.close();
+            return 1;
+        }
+        // From here on a fatal signal flushes the recorder and restores the tty
+        crash_guard::install(&recorder);
+        ncplane *stdp = notcurses_stdplane(nc);
+        g_nc = nc;
+        g_stdp = stdp;
+
+        // Make sure our target area fits in the terminal
+        unsigned termh = 0, termw = 0;
+        ncplane_dim_yx(stdp, &termh, &termw);
+        // Adaptive sizing: prefer double-width cells, fall back to single-width if needed.
+        const int HUDW_CHECK = 24;                      // keep in sync with render()
+        const int boardTW_double = 2 * (width - 1) + 1; // xscale=2
+        const int boardTW_single = width;               // xscale=1
+        // Fatal only if even single-width cannot fit, or height cannot fit
+        if ((int)height > (int)termh || (boardTW_single + 1 + HUDW_CHECK) > (int)termw)
+        {
+            ncplane_putstr_yx(stdp, 0, 0, "Terminal too small for configured game size.");
+            std::string hint = std::string("Need at least ") + std::to_string(height) + " rows x " + std::to_string(boardTW_single + 1 + HUDW_CHECK) + " cols.";
+            ncplane_putstr_yx(stdp, 1, 0, hint.c_str());
+            notcurses_render(nc);
+            crash_guard::uninstall();
+            destroyBoardLayer();
+            notcurses_stop(nc);
+            cast.close();
+            g_nc = nullptr;
+            g_stdp = nullptr;
+            return 1;
+        }
+        if (!input)
+        {
+            ownedInput = std::make_unique<NotcursesInput>(nc);
+            input = ownedInput.get();
+        }
     }
 
-    // At startup, prompt for player name in an in-game dialog
-    openDialog(DialogType::EnterName);
-    nameEntry.clear();
+    // Resume a suspended run paused, or prompt for the player name in an
+    // in-game dialog. A replay starts right away.
+    if (replay)
+    {
+        reset();
+    }
+    else if (resumeGame())
+    {
+        paused = true;
+        openDialog(DialogType::Pause);
+        recordingValid = false;
+    }
+    else
+    {
+        openDialog(DialogType::EnterName);
+        nameEntry.clear();
+        recording.begin(level, tickMs, fruit.seed());
+        recordingValid = true;
+    }
+    if (!replayDir.empty())
+        mkdir(replayDir.c_str(), 0755);
 
-    auto lastTick = std::chrono::steady_clock::now();
+    auto lastTick = clock->now();
+    // No jitter sample for the first tick after a pause, dialog or game
+    // over: that gap is the wait, not jitter
+    bool jitterValid = false;
 
     while (!exitRequested)
     {
         // Input
+        auto frameStart = clock->now();
         processInput();
+        auto inputDone = clock->now();
+        stats.record(FrameStats::Input, ns(inputDone - frameStart));
 
         // Tick based on tickMs when not paused and not over
-        if (!paused && !over)
+        uint32_t ticked = 0;
+        if (paused || over)
+            jitterValid = false;
+        else
         {
-            auto now = std::chrono::steady_clock::now();
-            if (std::chrono::duration_cast<std::chrono::milliseconds>(now - lastTick).count() >= tickMs)
+            auto now = inputDone;
+            // Fast replay playback runs a burst of ticks every frame
+            bool fast = replay && replayFast;
+            if (fast || std::chrono::duration_cast<std::chrono::milliseconds>(now - lastTick).count() >= tickMs)
             {
+                Metrics &m = metrics();
+                if (jitterValid)
+                    m.set(m.tickJitterNs, (int64_t)ns(now - lastTick) - (int64_t)tickMs * 1000000);
+                jitterValid = true;
                 lastTick = now;
-                update();
+                for (int burst = fast ? 2000 : 1; burst > 0 && !over; --burst)
+                {
+                    size_t lenBefore = snake.segments().size();
+                    update();
+                    ++ticked;
+
+                    const SampleWindow &fw = stats.window[FrameStats::Frame];
+                    const Point &h = snake.head();
+                    FlightRecord rec{};
+                    rec.tick = tick;
+                    rec.timeNs = ns(now.time_since_epoch());
+                    rec.frameNs = fw.filled() ? (uint32_t)std::min<uint64_t>(fw.recent(0), UINT32_MAX) : 0;
+                    rec.key = lastKey;
+                    rec.headX = (int16_t)h.x;
+                    rec.headY = (int16_t)h.y;
+                    rec.dir = (uint8_t)snake.getDirection();
+                    rec.flags = (snake.segments().size() > lenBefore ? FlightRecord::Grew : 0) |
+                                (over ? FlightRecord::Died : 0);
+                    recorder.record(rec);
+                    lastKey = 0;
+                    stats.record(FrameStats::Update, ns(clock->now() - now));
+                    m.count(m.ticks);
+                    m.set(m.snakeLength, (uint64_t)snake.segments().size());
+                }
             }
         }
 
         // Render
-        render();
-        notcurses_render(nc);
+        if (nc)
+        {
+            auto r0 = clock->now();
+            render();
+            auto r1 = clock->now();
+            {
+                TraceSpan span("notcurses_render");
+                notcurses_render(nc);
+            }
+            auto r2 = clock->now();
+            cast.frame(ns(r2.time_since_epoch()));
+            stats.record(FrameStats::Render, ns(r1 - r0));
+            stats.record(FrameStats::NcRender, ns(r2 - r1));
+
+            Metrics &m = metrics();
+            if (m.wantTerminalStats.load(std::memory_order_relaxed))
+            {
+                m.set(m.wantTerminalStats, false);
+                ncstats st{};
+                notcurses_stats(nc, &st);
+                m.set(m.terminalBytes, (uint64_t)st.raster_bytes);
+            }
+            m.set(m.renderNs, ns(r2 - r0));
+            m.count(m.frames);
+        }
+        auto frameEnd = clock->now();
+        stats.record(FrameStats::Frame, ns(frameEnd - frameStart));
+        stats.frameDone(ns(frameEnd.time_since_epoch()), ticked);
+        if (pendingScore >= 0)
+            submitScore();
+        refreshLeaderboard();
+        if (frameHook)
+            frameHook(frameHookCtx);
 
         // Small sleep to avoid busy loop
-        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        clock->sleepFor(std::chrono::milliseconds(5));
     }
 
-    notcurses_stop(nc);
+    if (nc)
+    {
+        // Final terminal byte count for the exporter's last snapshot
+        ncstats st{};
+        notcurses_stats(nc, &st);
+        metrics().set(metrics().terminalBytes, (uint64_t)st.raster_bytes);
+        crash_guard::uninstall();
+        destroyBoardLayer();
+        notcurses_stop(nc);
+        cast.close();
+        g_nc = nullptr;
+        g_stdp = nullptr;
+    }
+    // Quitting mid-run keeps the run for next time
+    if (!over && tick > 0)
+        suspended = saveGame();
+    recorder.close();
+    if (!statsFile.empty())
+    {
+        std::ofstream out(statsFile, std::ios::trunc);
+        if (out.good())
+            stats.dump(out);
+    }
     return score;
 }
 
 void Game::processInput()
 {
-    if (!g_nc)
+    TraceSpan span("Game::processInput");
+    if (!input)
         return;
-    ncinput ni{};
     // Drain all pending inputs non-blocking
     while (true)
     {
-        uint32_t key = notcurses_get_nblock(g_nc, &ni);
+        uint32_t key = input->poll();
         if (key == 0u)
             break; // no input available
         if (key == (uint32_t)-1)
             break; // error
+        metrics().count(metrics().inputEvents);
+        lastKey = key;
+
+        // Practice rewind, also from the Pause and Game Over dialogs
+        if (practice && (key == 'b' || key == 'B') &&
+            !(dialogOpen && (dialogType == DialogType::EnterName || dialogType == DialogType::GoToTick)))
+        {
+            rewindTicks(std::max(1, 3000 / tickMs));
+            continue;
+        }
+
+        // Replay scrubbing also works over the Pause and Game Over dialogs
+        if (replay && !(dialogOpen && dialogType == DialogType::GoToTick))
+        {
+            if (key == '[')
+            {
+                seekReplay(tick > 1000 ? tick - 1000 : 0);
+                continue;
+            }
+            if (key == ']')
+            {
+                seekReplay(tick + 1000);
+                continue;
+            }
+            if (key == 'j' || key == 'J')
+            {
+                openDialog(DialogType::GoToTick);
+                continue;
+            }
+        }
 
         // If a modal dialog is open, handle its input
         if (dialogOpen)
@@ -153,6 +379,31 @@ void Game::processInput()
                 continue;
             }
 
+            // Tick number for replay seeking; Esc cancels
+            if (dialogType == DialogType::GoToTick)
+            {
+                if (key == '\n' || key == NCKEY_ENTER)
+                {
+                    if (!nameEntry.empty())
+                        seekReplay(std::strtoull(nameEntry.c_str(), nullptr, 10));
+                    closeDialog();
+                    paused = false;
+                }
+                else if (key == NCKEY_ESC)
+                {
+                    closeDialog();
+                    paused = false;
+                }
+                else if (key == 127 || key == 8)
+                {
+                    if (!nameEntry.empty())
+                        nameEntry.pop_back();
+                }
+                else if (key >= '0' && key <= '9' && nameEntry.size() < 19)
+                    nameEntry.push_back(static_cast<char>(key));
+                continue;
+            }
+
             // (EnterSize dialog removed)
 
             int maxIdx = (dialogType == DialogType::Pause ? 2 : 1);
@@ -219,7 +470,7 @@ void Game::processInput()
         }
 
         auto handle_dir = [&](Direction d)
-        { if (!paused && !over) snake.setDirection(d); };
+        { if (!paused && !over && !replay) snake.setDirection(d); };
 
         if (key == NCKEY_UP)
         {
@@ -262,6 +513,8 @@ void Game::processInput()
             paused = !paused;
             if (paused)
             {
+                if (!over)
+                    saveGame();
                 openDialog(DialogType::Pause);
                 dialogIndex = 0;
             }
@@ -275,6 +528,14 @@ void Game::processInput()
             if (over)
                 reset();
         }
+        else if (key == 't' || key == 'T')
+        {
+            showStats = !showStats;
+        }
+        else if ((key == 'f' || key == 'F') && replay)
+        {
+            replayFast = !replayFast;
+        }
         else if (key == 'g' || key == 'G')
         {
             // cycle snake glyph style
@@ -314,6 +575,7 @@ void Game::processInput()
 
 void Game::render() const
 {
+    TraceSpan span("Game::render");
     if (!g_stdp)
         return;
     ncplane_erase(g_stdp);
@@ -332,72 +594,14 @@ void Game::render() const
         ox = 0;
     int hx = ox + boardTW + 1; // HUD x
 
-    // Draw board border with UTF-8 double lines and gradient color
-    const char *hline = "═";
-    const char *vline = "║";
-    const char *tl = "╔";
-    const char *tr = "╗";
-    const char *bl = "╚";
-    const char *br = "╝";
-    auto grad = [&](float t, uint8_t &r, uint8_t &g, uint8_t &b)
-    {
-        // from bluish (120,160,255) to aqua (120,255,200)
-        int r1 = 120, g1 = 160, b1 = 255, r2 = 120, g2 = 255, b2 = 200;
-        r = (uint8_t)(r1 + (r2 - r1) * t);
-        g = (uint8_t)(g1 + (g2 - g1) * t);
-        b = (uint8_t)(b1 + (b2 - b1) * t);
-    };
-    // corners
-    uint8_t cr, cg, cb;
-    grad(0.0f, cr, cg, cb);
-    set_fg(g_stdp, cr, cg, cb);
-    ncplane_putstr_yx(g_stdp, oy + 0, ox + 0, tl);
-    grad(1.0f, cr, cg, cb);
-    set_fg(g_stdp, cr, cg, cb);
-    ncplane_putstr_yx(g_stdp, oy + 0, ox + boardTW - 1, tr);
-    grad(0.0f, cr, cg, cb);
-    set_fg(g_stdp, cr, cg, cb);
-    ncplane_putstr_yx(g_stdp, oy + height - 1, ox + 0, bl);
-    grad(1.0f, cr, cg, cb);
-    set_fg(g_stdp, cr, cg, cb);
-    ncplane_putstr_yx(g_stdp, oy + height - 1, ox + boardTW - 1, br);
-    // top/bottom across terminal columns
-    for (int tx = 1; tx < boardTW - 1; ++tx)
-    {
-        float t = (float)tx / (float)(boardTW - 1);
-        grad(t, cr, cg, cb);
-        set_fg(g_stdp, cr, cg, cb);
-        ncplane_putstr_yx(g_stdp, oy + 0, ox + tx, hline);
-        ncplane_putstr_yx(g_stdp, oy + height - 1, ox + tx, hline);
-    }
-    // sides
-    for (int y = 1; y < height - 1; ++y)
+    // Border, walls and grid dots come from the pre-drawn board layer
+    if (!boardLayer || boardLayerScale != xscale)
+        drawBoardLayer(xscale);
+    if (boardLayer && (boardLayerY != oy || boardLayerX != ox))
     {
-        float t = (float)y / (float)(height - 1);
-        grad(t, cr, cg, cb);
-        set_fg(g_stdp, cr, cg, cb);
-        ncplane_putstr_yx(g_stdp, oy + y, ox + 0, vline);
-        grad(1.0f - t, cr, cg, cb);
-        set_fg(g_stdp, cr, cg, cb);
-        ncplane_putstr_yx(g_stdp, oy + y, ox + boardTW - 1, vline);
-    }
-
-    // Subtle grid inside the board (checker pattern) to make cells visible
-    // Use dim dots so snake and fruit remain readable; they will overwrite dots where they sit.
-    for (int y = 1; y < height - 1; ++y)
-    {
-        for (int x = 1; x < width - 1; ++x)
-        {
-            bool alt = ((x + y) & 1) == 1;
-            // two subtle greys
-            uint8_t gr = alt ? 70 : 55;
-            uint8_t gg = alt ? 75 : 60;
-            uint8_t gb = alt ? 85 : 70;
-            set_fg(g_stdp, gr, gg, gb);
-            int tx = ox + x * xscale;
-            for (int k = 0; k < xscale; ++k)
-                ncplane_putstr_yx(g_stdp, oy + y, tx + k, "·");
-        }
+        ncplane_move_yx(boardLayer, oy, ox);
+        boardLayerY = oy;
+        boardLayerX = ox;
     }
 
     // Side HUD panel
@@ -455,25 +659,58 @@ void Game::render() const
     ncplane_putstr_yx(g_stdp, oy + 1, hx + 10, playerName.c_str());
     set_fg(g_stdp, 255, 215, 0);
     ncplane_putstr_yx(g_stdp, oy + 3, hx + 2, "Score:");
+    // Fixed buffers: the steady-state frame must not touch the heap
+    char num[16];
     set_fg(g_stdp, 255, 255, 255);
-    ncplane_putstr_yx(g_stdp, oy + 3, hx + 10, std::to_string(score).c_str());
+    snprintf(num, sizeof num, "%d", score);
+    ncplane_putstr_yx(g_stdp, oy + 3, hx + 10, num);
     set_fg(g_stdp, 0, 255, 180);
     ncplane_putstr_yx(g_stdp, oy + 5, hx + 2, "High:");
     set_fg(g_stdp, 255, 255, 255);
-    ncplane_putstr_yx(g_stdp, oy + 5, hx + 10, std::to_string(highScore).c_str());
+    snprintf(num, sizeof num, "%d", highScore);
+    ncplane_putstr_yx(g_stdp, oy + 5, hx + 10, num);
     set_fg(g_stdp, 200, 200, 200);
     ncplane_putstr_yx(g_stdp, oy + 7, hx + 2, "Controls:");
     set_fg(g_stdp, 180, 180, 180);
     ncplane_putstr_yx(g_stdp, oy + 8, hx + 2, "Arrows/WASD move");
     ncplane_putstr_yx(g_stdp, oy + 9, hx + 2, "p/space pause");
     ncplane_putstr_yx(g_stdp, oy + 10, hx + 2, "q quit");
-    // Optional hint for glyph styles
-    set_fg(g_stdp, 170, 170, 170);
-    ncplane_putstr_yx(g_stdp, oy + 12, hx + 2, "g: change snake style");
+    if (replay)
+    {
+        // Playback status and scrub keys replace the style/timing hints
+        char line[32];
+        set_fg(g_stdp, 255, 120, 200);
+        snprintf(line, sizeof line, "Replay %-4s f:speed", replayFast ? "fast" : "1x");
+        ncplane_putstr_yx(g_stdp, oy + 11, hx + 2, line);
+        set_fg(g_stdp, 170, 170, 170);
+        ncplane_putstr_yx(g_stdp, oy + 12, hx + 2, "[ ]:-+1000 j:go to");
+        snprintf(line, sizeof line, "%llu/%llu", (unsigned long long)tick,
+                 (unsigned long long)replay->header().ticks);
+        ncplane_putstr_yx(g_stdp, oy + 13, hx + 2, line);
+    }
+    else if (practice)
+    {
+        set_fg(g_stdp, 255, 120, 200);
+        ncplane_putstr_yx(g_stdp, oy + 11, hx + 2, paused && !dialogOpen ? "Practice (paused)" : "Practice");
+        set_fg(g_stdp, 170, 170, 170);
+        ncplane_putstr_yx(g_stdp, oy + 12, hx + 2, "b: rewind 3s");
+        ncplane_putstr_yx(g_stdp, oy + 13, hx + 2, "t: frame timings");
+    }
+    else
+    {
+        // Optional hint for glyph styles
+        set_fg(g_stdp, 170, 170, 170);
+        ncplane_putstr_yx(g_stdp, oy + 12, hx + 2, "g: change snake style");
+        ncplane_putstr_yx(g_stdp, oy + 13, hx + 2, "t: frame timings");
+    }
+    if (showStats)
+        renderStats(oy, hx);
+    else
+        renderLeaderboard(oy, hx);
 
     // Fruit (solid circle)
     const auto &fp = fruit.position();
-    set_fg(g_stdp, 255, 80, 80);
+    set_fg(g_stdp, palette::fruit.r, palette::fruit.g, palette::fruit.b);
     {
         int ftx = ox + fp.x * xscale;
         for (int k = 0; k < xscale; ++k)
@@ -486,23 +723,10 @@ void Game::render() const
     // Color gradient: lime (head) -> yellow (mid) -> cyan (tail)
     auto sgrad = [&](float t, uint8_t &r, uint8_t &g, uint8_t &b)
     {
-        int r0 = 80, g0 = 255, b0 = 120; // lime
-        int r1 = 255, g1 = 220, b1 = 0;  // yellow
-        int r2 = 0, g2 = 220, b2 = 255;  // cyan
-        if (t <= 0.5f)
-        {
-            float u = t * 2.0f;
-            r = (uint8_t)(r0 + (int)((r1 - r0) * u));
-            g = (uint8_t)(g0 + (int)((g1 - g0) * u));
-            b = (uint8_t)(b0 + (int)((b1 - b0) * u));
-        }
-        else
-        {
-            float u = (t - 0.5f) * 2.0f;
-            r = (uint8_t)(r1 + (int)((r2 - r1) * u));
-            g = (uint8_t)(g1 + (int)((g2 - g1) * u));
-            b = (uint8_t)(b1 + (int)((b2 - b1) * u));
-        }
+        palette::Rgb c = palette::snake(t);
+        r = c.r;
+        g = c.g;
+        b = c.b;
     };
     for (int i = 0; i < nseg; ++i)
     {
@@ -678,17 +902,19 @@ void Game::render() const
             ncplane_putstr_yx(g_stdp, dy + drows - 1, dx + x, "═");
         ncplane_putstr_yx(g_stdp, dy + drows - 1, dx + dcols - 1, "╝");
 
-        std::string title;
+        const char *title;
         if (dialogType == DialogType::EnterName)
             title = "Enter Player Name";
+        else if (dialogType == DialogType::GoToTick)
+            title = "Go to Tick";
         else if (dialogType == DialogType::Pause)
             title = "Pause";
         else
             title = "Game Over";
 
-        int tx = dx + (dcols - (int)title.size()) / 2;
+        int tx = dx + (dcols - (int)strlen(title)) / 2;
         set_fg(g_stdp, 120, 200, 255);
-        ncplane_putstr_yx(g_stdp, dy + 1, tx, title.c_str());
+        ncplane_putstr_yx(g_stdp, dy + 1, tx, title);
 
         // For EnterName, show input controls and instructions
         if (dialogType == DialogType::EnterName)
@@ -696,11 +922,20 @@ void Game::render() const
             set_fg(g_stdp, 200, 200, 200);
             ncplane_putstr_yx(g_stdp, dy + 3, dx + 3, "Type your name and press Enter:");
             set_fg(g_stdp, 255, 255, 255);
-            std::string shown = nameEntry.empty() ? std::string("(Player)") : nameEntry;
             // Ensure it fits
-            if ((int)shown.size() > dcols - 6)
-                shown = shown.substr(0, dcols - 6);
-            ncplane_putstr_yx(g_stdp, dy + 4, dx + 3, shown.c_str());
+            char shown[64];
+            snprintf(shown, sizeof shown, "%.*s", dcols - 6, nameEntry.empty() ? "(Player)" : nameEntry.c_str());
+            ncplane_putstr_yx(g_stdp, dy + 4, dx + 3, shown);
+        }
+        else if (dialogType == DialogType::GoToTick)
+        {
+            char line[64];
+            set_fg(g_stdp, 200, 200, 200);
+            snprintf(line, sizeof line, "Tick 0-%llu, Enter (Esc cancels):",
+                     (unsigned long long)(replay ? replay->header().ticks : 0));
+            ncplane_putstr_yx(g_stdp, dy + 3, dx + 3, line);
+            set_fg(g_stdp, 255, 255, 255);
+            ncplane_putstr_yx(g_stdp, dy + 4, dx + 3, nameEntry.empty() ? "_" : nameEntry.c_str());
         }
         else
         {
@@ -708,8 +943,9 @@ void Game::render() const
             if (dialogType == DialogType::GameOver)
             {
                 set_fg(g_stdp, 200, 200, 0);
-                std::string scoreLine = std::string("Score: ") + std::to_string(score);
-                ncplane_putstr_yx(g_stdp, dy + 2, dx + 3, scoreLine.c_str());
+                char scoreLine[32];
+                snprintf(scoreLine, sizeof scoreLine, "Score: %d", score);
+                ncplane_putstr_yx(g_stdp, dy + 2, dx + 3, scoreLine);
             }
 
             auto draw_option = [&](int row, int idx, const char *label)
@@ -719,8 +955,12 @@ void Game::render() const
                     set_fg(g_stdp, 255, 255, 255);
                 else
                     set_fg(g_stdp, 180, 180, 180);
-                std::string line = sel ? (std::string("▶ ") + label + " ◀") : (std::string("  ") + label);
-                ncplane_putstr_yx(g_stdp, dy + row, dx + 3, line.c_str());
+                char line[64];
+                if (sel)
+                    snprintf(line, sizeof line, "▶ %s ◀", label);
+                else
+                    snprintf(line, sizeof line, "  %s", label);
+                ncplane_putstr_yx(g_stdp, dy + row, dx + 3, line);
             };
             if (dialogType == DialogType::Pause)
             {
@@ -732,59 +972,496 @@ void Game::render() const
             {
                 draw_option(3, 0, "Restart");
                 draw_option(4, 1, "Quit");
+                if (practice && rewindBuf.size() > 0)
+                {
+                    set_fg(g_stdp, 255, 120, 200);
+                    ncplane_putstr_yx(g_stdp, dy + 5, dx + 3, "b: rewind 3s");
+                }
+            }
+        }
+    }
+}
+
+void Game::renderLeaderboard(int oy, int hx) const
+{
+    // Top scores across every instance sharing the file, below the controls,
+    // then the score history's totals (kept in memory, no file reads)
+    const int first = 15;
+    int row = first;
+    char buf[32];
+    if (topCount > 0 && row < height - 1)
+    {
+        set_fg(g_stdp, 0, 255, 180);
+        ncplane_putstr_yx(g_stdp, oy + row++, hx + 2, "Leaderboard:");
+        for (int i = 0; i < topCount && row < height - 1; ++i, ++row)
+        {
+            if (top[i].score == score && std::strncmp(top[i].name, playerName.c_str(), sizeof top[i].name - 1) == 0)
+                set_fg(g_stdp, 255, 215, 0);
+            else
+                set_fg(g_stdp, 200, 200, 200);
+            snprintf(buf, sizeof buf, "%2d %-11.11s%6d", i + 1, top[i].name, top[i].score);
+            ncplane_putstr_yx(g_stdp, oy + row, hx + 2, buf);
+        }
+        ++row;
+    }
+    const ScoreJournal::Summary &hist = journal.summary();
+    if (hist.games > 0 && row < height - 1)
+    {
+        set_fg(g_stdp, 170, 170, 170);
+        snprintf(buf, sizeof buf, "%llu games, best %d", (unsigned long long)hist.games,
+                 hist.topCount ? hist.top[0].score : 0);
+        ncplane_putstr_yx(g_stdp, oy + row, hx + 2, buf);
+    }
+}
+
+void Game::drawBoardLayer(int xscale) const
+{
+    destroyBoardLayer();
+    const int boardTW = xscale * (width - 1) + 1;
+    ncplane_options opts{};
+    opts.rows = (unsigned)height;
+    opts.cols = (unsigned)boardTW;
+    ncplane *n = ncplane_create(g_stdp, &opts);
+    if (!n)
+        return;
+    // Underneath everything else; the standard plane lets it show through
+    // wherever render() leaves a cell empty
+    ncplane_move_bottom(n);
+    uint64_t clear = 0;
+    ncchannels_set_fg_alpha(&clear, NCALPHA_TRANSPARENT);
+    ncchannels_set_bg_alpha(&clear, NCALPHA_TRANSPARENT);
+    ncplane_set_base(g_stdp, "", 0, clear);
+    boardLayer = n;
+    boardLayerScale = xscale;
+    boardLayerY = boardLayerX = 0;
+
+    // Draw board border with UTF-8 double lines and gradient color; a torus
+    // seam is dashed
+    bool torus = level.topology() == Topology::Torus;
+    const char *hline = torus ? "╌" : "═";
+    const char *vline = torus ? "╎" : "║";
+    const char *tl = torus ? "┌" : "╔";
+    const char *tr = torus ? "┐" : "╗";
+    const char *bl = torus ? "└" : "╚";
+    const char *br = torus ? "┘" : "╝";
+    auto grad = [&](float t, uint8_t &r, uint8_t &g, uint8_t &b)
+    {
+        palette::Rgb c = palette::border(t);
+        r = c.r;
+        g = c.g;
+        b = c.b;
+    };
+    // corners
+    uint8_t cr, cg, cb;
+    grad(0.0f, cr, cg, cb);
+    set_fg(n, cr, cg, cb);
+    ncplane_putstr_yx(n, 0, 0, tl);
+    grad(1.0f, cr, cg, cb);
+    set_fg(n, cr, cg, cb);
+    ncplane_putstr_yx(n, 0, boardTW - 1, tr);
+    grad(0.0f, cr, cg, cb);
+    set_fg(n, cr, cg, cb);
+    ncplane_putstr_yx(n, height - 1, 0, bl);
+    grad(1.0f, cr, cg, cb);
+    set_fg(n, cr, cg, cb);
+    ncplane_putstr_yx(n, height - 1, boardTW - 1, br);
+    // top/bottom across terminal columns
+    for (int tx = 1; tx < boardTW - 1; ++tx)
+    {
+        float t = (float)tx / (float)(boardTW - 1);
+        grad(t, cr, cg, cb);
+        set_fg(n, cr, cg, cb);
+        ncplane_putstr_yx(n, 0, tx, hline);
+        ncplane_putstr_yx(n, height - 1, tx, hline);
+    }
+    // sides
+    for (int y = 1; y < height - 1; ++y)
+    {
+        float t = (float)y / (float)(height - 1);
+        grad(t, cr, cg, cb);
+        set_fg(n, cr, cg, cb);
+        ncplane_putstr_yx(n, y, 0, vline);
+        grad(1.0f - t, cr, cg, cb);
+        set_fg(n, cr, cg, cb);
+        ncplane_putstr_yx(n, y, boardTW - 1, vline);
+    }
+
+    // Subtle grid inside the board (checker pattern) to make cells visible
+    // Use dim dots so snake and fruit remain readable; they will overwrite dots where they sit.
+    // Inner walls of a level are solid blocks in the gradient across the board.
+    for (int y = 1; y < height - 1; ++y)
+    {
+        for (int x = 1; x < width - 1; ++x)
+        {
+            int tx = x * xscale;
+            if (level.wall({x, y}))
+            {
+                grad((float)x / (float)(width - 1), cr, cg, cb);
+                set_fg(n, cr, cg, cb);
+                for (int k = 0; k < xscale; ++k)
+                    ncplane_putstr_yx(n, y, tx + k, "█");
+                continue;
             }
+            bool alt = ((x + y) & 1) == 1;
+            palette::Rgb gc = palette::grid(alt);
+            set_fg(n, gc.r, gc.g, gc.b);
+            for (int k = 0; k < xscale; ++k)
+                ncplane_putstr_yx(n, y, tx + k, "·");
         }
     }
+    // Both ends of a portal in the pair's colour
+    for (size_t i = 0; i < level.portals().size(); ++i)
+    {
+        const LevelPortal &p = level.portals()[i];
+        palette::Rgb pc = palette::portal(i);
+        set_fg(n, pc.r, pc.g, pc.b);
+        for (int k = 0; k < xscale; ++k)
+        {
+            ncplane_putstr_yx(n, p.ay, p.ax * xscale + k, "◎");
+            ncplane_putstr_yx(n, p.by, p.bx * xscale + k, "◎");
+        }
+    }
+}
+
+void Game::destroyBoardLayer() const
+{
+    if (!boardLayer)
+        return;
+    ncplane_destroy(boardLayer);
+    boardLayer = nullptr;
+    boardLayerScale = 0;
+}
+
+void Game::renderStats(int oy, int hx) const
+{
+    // Timing panel below the controls: p50/p99/max over the last
+    // SampleWindow::size frames, loop rates, and a frame-time sparkline
+    const int top = 15;
+    auto row = [&](int r)
+    { return r < height - 1; };
+    char buf[64];
+    if (!row(top))
+        return;
+    set_fg(g_stdp, 120, 200, 255);
+    ncplane_putstr_yx(g_stdp, oy + top, hx + 2, "µs     p50  p99  max");
+    static const char *labels[] = {"in   ", "upd  ", "draw ", "nc   ", "frame"};
+    set_fg(g_stdp, 220, 220, 220);
+    for (int p = 0; p < FrameStats::PhaseCount; ++p)
+    {
+        if (!row(top + 1 + p))
+            return;
+        const SampleWindow &w = stats.window[p];
+        char p50[16], p99[16], mx[16];
+        fmt_us(p50, sizeof p50, w.percentile(0.50));
+        fmt_us(p99, sizeof p99, w.percentile(0.99));
+        fmt_us(mx, sizeof mx, w.max());
+        snprintf(buf, sizeof buf, "%s%s%s%s", labels[p], p50, p99, mx);
+        ncplane_putstr_yx(g_stdp, oy + top + 1 + p, hx + 2, buf);
+    }
+    int r = top + 1 + FrameStats::PhaseCount;
+    if (!row(r + 1))
+        return;
+    set_fg(g_stdp, 200, 200, 200);
+    snprintf(buf, sizeof buf, "tick/s %4.0f fps %4.0f", stats.ticksPerSec, stats.framesPerSec);
+    ncplane_putstr_yx(g_stdp, oy + r, hx + 2, buf);
+
+    // Sparkline, oldest on the left
+    static const char *bars[] = {"▁", "▂", "▃", "▄", "▅", "▆", "▇", "█"};
+    const SampleWindow &fw = stats.window[FrameStats::Frame];
+    const int cols = 20;
+    int n = std::min(cols, fw.filled());
+    uint64_t peak = 1;
+    for (int i = 0; i < n; ++i)
+        peak = std::max(peak, fw.recent(i));
+    set_fg(g_stdp, 80, 255, 120);
+    for (int i = 0; i < n; ++i)
+    {
+        uint64_t v = fw.recent(n - 1 - i);
+        int level = (int)(v * 7 / peak);
+        ncplane_putstr_yx(g_stdp, oy + r + 1, hx + 2 + i, bars[level]);
+    }
 }
 
 void Game::update()
 {
-    // Compute next head and collisions
-    Point next = snake.nextHead();
+    TraceSpan span("Game::update");
+    ++tick;
+    Direction d;
+    if (!replay)
+        recording.step(tick, snake.getDirection());
+    else if (replayCursor.turnAt(tick, d))
+        snake.setDirection(d);
 
-    // Walls
-    if (next.x <= 0 || next.x >= width - 1 || next.y <= 0 || next.y >= height - 1)
+    // Enough to undo this tick in O(1): the tail it may drop, the fruit it
+    // may move, the score it may add
+    TickDelta delta{snake.segments().back(), fruit.position(), 0, (uint8_t)snake.lastMove(),
+                    (uint8_t)snake.getDirection(), 0};
+    int before = score;
+    StepResult result = stepRules(level, snake, fruit, score);
+    if (isDeath(result))
     {
-        over = true;
-        openDialog(DialogType::GameOver);
+        endGame();
         return;
     }
+    if (practice)
+    {
+        delta.grew = result == StepResult::Grew;
+        delta.scoreDelta = (int8_t)(score - before);
+        rewindBuf.push(delta);
+    }
+    if (score > highScore)
+        highScore = score;
+}
 
-    // Self
-    if (snake.hitsSelf(next))
+void Game::endGame()
+{
+    over = true;
+    if (replay)
     {
-        over = true;
         openDialog(DialogType::GameOver);
         return;
     }
+    pendingScore = score;
+    recordGame();
+    if (recordingValid)
+        saveReplay();
+    // A finished run can't be resumed
+    if (!saveFile.empty())
+        std::remove(saveFile.c_str());
+    openDialog(DialogType::GameOver);
+}
+
+void Game::recordGame()
+{
+    GameRecord r{};
+    r.timeSec = (uint64_t)std::time(nullptr);
+    r.durationMs = tick * (uint64_t)tickMs;
+    r.ticks = tick;
+    r.score = score;
+    r.length = (uint32_t)snake.segments().size();
+    r.seed = fruit.seed();
+    std::strncpy(r.name, playerName.c_str(), sizeof r.name - 1);
+    journal.append(r);
+}
+
+bool Game::saveGame()
+{
+    if (saveFile.empty())
+        return false;
+    SavedGame g;
+    g.width = width;
+    g.height = height;
+    g.level = level.id();
+    g.score = score;
+    g.tickMs = tickMs;
+    g.tick = tick;
+    g.seed = seed;
+    g.seeded = seeded;
+    std::strncpy(g.name, playerName.c_str(), sizeof g.name - 1);
+    return save_game::write(saveFile, g, snake, fruit);
+}
+
+bool Game::resumeGame()
+{
+    if (saveFile.empty())
+        return false;
+    SavedGame g;
+    if (!save_game::read(saveFile, level, g, snake, fruit))
+    {
+        // A rejected body leaves the snake wherever read() put it
+        snake.reset(level.spawn().x, level.spawn().y, 3);
+        return false;
+    }
+    score = g.score;
+    tickMs = g.tickMs;
+    tick = g.tick;
+    seed = g.seed;
+    seeded = g.seeded;
+    playerName = g.name;
+    over = false;
+    if (score > highScore)
+        highScore = score;
+    return true;
+}
+
+void Game::saveReplay()
+{
+    if (replayDir.empty())
+        return;
+    // Fixed buffers: this runs inside a frame
+    char when[32];
+    std::time_t now = std::time(nullptr);
+    std::tm tm{};
+    localtime_r(&now, &tm);
+    std::strftime(when, sizeof when, "%Y%m%d-%H%M%S", &tm);
+    char path[512];
+    int n = snprintf(path, sizeof path, "%s/%s-%d-%d.bhr", replayDir.c_str(), when, (int)getpid(), score);
+    if (n > 0 && n < (int)sizeof path)
+        recording.save(path, tick, score, (uint32_t)snake.segments().size(), playerName.c_str());
+}
+
+void Game::seekReplay(uint64_t target)
+{
+    // Stop one tick short of the end, so the final move can be watched
+    uint64_t ticks = replay->header().ticks;
+    if (ticks > 0)
+        target = std::min(target, ticks - 1);
+    const ReplayKeyframe &k = replayIndex.at(target);
+    ReplayIndex::restore(k, snake, fruit);
+    replayCursor = k.cursor;
+    score = k.score;
+    tick = ReplayIndex::skip(k, target); // whole laps of a periodic stretch are free
+    over = false;
+    if (dialogOpen && dialogType == DialogType::GameOver)
+        closeDialog();
+    while (tick < target && !over)
+        update();
+}
+
+void Game::rewindTicks(int n)
+{
+    if (rewindBuf.size() == 0)
+        return;
+    // The fatal tick counted but changed nothing
+    if (over)
+        --tick;
+    TickDelta d;
+    for (int i = 0; i < n && rewindBuf.pop(d); ++i)
+    {
+        snake.unmove(d.tail, d.grew != 0, (Direction)d.dir, (Direction)d.before);
+        fruit.place(d.fruit);
+        score -= d.scoreDelta;
+        --tick;
+    }
+    // Back to a live game, held still until the player resumes
+    over = false;
+    closeDialog();
+    paused = true;
+}
 
-    bool grow = false;
-    if (next == fruit.position())
+void Game::setPracticeMode(bool on)
+{
+    practice = on;
+    rewindBuf.clear();
+    if (on)
     {
-        grow = true;
-        score += 10;
-        if (score > highScore)
-            highScore = score;
-        fruit.respawn([&](const Point &p)
-                      { return snake.contains(p) || p == next; });
+        saveFile.clear();
+        historyBase.clear();
+        leaderboardFile.clear();
+        replayDir.clear();
     }
+}
 
-    snake.move(grow);
+bool Game::setReplay(const Replay &r, bool fast)
+{
+    if (!levelMatches(r.header(), level))
+        return false;
+    replay = &r;
+    replayIndex.build(r, level);
+    replayFast = fast;
+    tickMs = r.header().tickMs;
+    const char *name = r.header().name;
+    playerName.assign(name, strnlen(name, sizeof r.header().name));
+    saveFile.clear();
+    historyBase.clear();
+    leaderboardFile.clear();
+    replayDir.clear();
+    return true;
 }
 
 void Game::reset()
 {
+    // Restarting abandons any suspended run
+    if (!saveFile.empty())
+        std::remove(saveFile.c_str());
     score = 0;
+    tick = 0;
     over = false;
     exitRequested = false;
     dialogOpen = false;
     dialogType = DialogType::None;
     dialogIndex = 0;
     paused = false;
-    snake = Snake(width / 2, height / 2, 3);
-    fruit = Fruit(width, height);
+    if (replay)
+    {
+        replayStart(*replay, level, snake, fruit, replayCursor);
+    }
+    else
+    {
+        if (seeded)
+            fruit.reseed(seed);
+        else
+            fruit.reseed();
+        newBoard();
+    }
+    recording.begin(level, tickMs, fruit.seed());
+    recordingValid = true;
+    rewindBuf.clear();
+}
+
+void Game::attachNotcurses(notcurses *nc)
+{
+    destroyBoardLayer();
+    g_nc = nc;
+    g_stdp = nc ? notcurses_stdplane(nc) : nullptr;
+}
+
+void Game::setSeed(unsigned s)
+{
+    seeded = true;
+    seed = s;
+    fruit = Fruit(width, height, seed);
+    newBoard();
+}
+
+// The snake at the spawn and the fruit placed, on a freshly generated board
+// first when there is a level style. The generator's buffers are warm after
+// the first game, so this doesn't allocate.
+void Game::newBoard()
+{
+    if (levelStyle)
+    {
+        levelGen.generate((LevelStyle)levelStyle, width, height, fruit.seed(), level);
+        destroyBoardLayer();
+    }
+    snake.reset(level.spawn().x, level.spawn().y, 3);
+    // The first fruit comes from a fresh placement sequence, as replayStart()
+    // rebuilds it, however many boards this seed has already been drawn on
+    fruit.reseed(fruit.seed());
     fruit.respawn([&](const Point &p)
-                  { return snake.contains(p); });
+                  { return snake.contains(p) || level.wall(p); });
+}
+
+void Game::setLevelStyle(LevelStyle s)
+{
+    levelStyle = (uint32_t)s;
+    // The board changes every game, so a save couldn't be resumed on it
+    saveFile.clear();
+    newBoard();
+}
+
+bool Game::loadLevel(const std::string &path)
+{
+    Level l;
+    if (!l.open(path))
+        return false;
+    setLevel(std::move(l));
+    return true;
+}
+
+void Game::setLevel(Level &&l)
+{
+    level = std::move(l);
+    destroyBoardLayer();
+    width = level.width();
+    height = level.height();
+    // Segment storage for the whole board, as for the plain one, up to a
+    // million segments; a snake longer than that grows its ring as it goes
+    size_t cells = std::min<size_t>((size_t)width * (size_t)height, (size_t)1 << 20);
+    snake = Snake(level.spawn().x, level.spawn().y, 3, cells);
+    fruit = seeded ? Fruit(width, height, seed) : Fruit(width, height);
+    fruit.respawn([&](const Point &p)
+                  { return snake.contains(p) || level.wall(p); });
 }
 
 void Game::chooseDifficulty()
@@ -794,23 +1471,64 @@ void Game::chooseDifficulty()
     tickMs = 120; // default normal
 }
 
-void Game::loadHighScore()
+void Game::setLeaderboardFile(const std::string &path)
 {
-    std::ifstream in(highScoreFile);
-    if (!in.good())
+    leaderboardFile = path;
+    leaderboard.close();
+    topCount = 0;
+    topGeneration = ~0ull;
+    if (!path.empty() && leaderboard.open(path))
+        importHighScore(path);
+    refreshLeaderboard();
+}
+
+// Older builds kept a single number in highscore.txt. Carry it into a
+// fresh leaderboard once, then rename the file so it isn't imported again.
+void Game::importHighScore(const std::string &leaderboardPath)
+{
+    LeaderboardEntry probe[Leaderboard::Capacity];
+    if (leaderboard.snapshot(probe) != 0)
         return;
+    size_t slash = leaderboardPath.rfind('/');
+    std::string old = (slash == std::string::npos ? std::string() : leaderboardPath.substr(0, slash + 1)) + "highscore.txt";
+    std::ifstream in(old);
     int hs = 0;
-    in >> hs;
-    if (in)
-        highScore = hs;
+    struct stat st{};
+    if (!(in >> hs) || hs <= 0 || stat(old.c_str(), &st) != 0)
+        return;
+    if (leaderboard.submit("imported", hs, (uint64_t)st.st_mtime))
+        std::rename(old.c_str(), (old + ".imported").c_str());
 }
 
-void Game::saveHighScore()
+void Game::setHistoryFile(const std::string &base)
 {
-    std::ofstream out(highScoreFile, std::ios::trunc);
-    if (!out.good())
+    historyBase = base;
+    journal.close();
+    if (!base.empty())
+        journal.open(base);
+}
+
+void Game::refreshLeaderboard()
+{
+    // One atomic load per frame; copy the table only when someone published
+    uint64_t gen = leaderboard.generation();
+    if (gen == topGeneration)
+        return;
+    topGeneration = gen;
+    topCount = leaderboard.snapshot(top);
+    if (topCount > 0 && top[0].score > highScore)
+        highScore = top[0].score;
+}
+
+void Game::submitScore()
+{
+    if (pendingScore <= 0 || !leaderboard.isOpen())
+    {
+        pendingScore = -1;
         return;
-    out << highScore << "\n";
+    }
+    if (leaderboard.submit(playerName.c_str(), pendingScore, (uint64_t)std::time(nullptr)))
+        pendingScore = -1;
 }
 
 void Game::openDialog(DialogType t)
@@ -818,10 +1536,10 @@ void Game::openDialog(DialogType t)
     dialogType = t;
     dialogOpen = true;
     dialogIndex = 0;
-    if (t == DialogType::EnterName)
+    if (t == DialogType::EnterName || t == DialogType::GoToTick)
     {
         nameEntry.clear();
-        // Pause the game while asking for the player's name
+        // Pause the game while asking for the player's name or a tick
         paused = true;
     }
 }
@@ -0,0 +1,108 @@
+// Input sources: live Notcurses keyboard and scripted key files
+#include "input.h"
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+#include <notcurses/notcurses.h>
+
+uint32_t NotcursesInput::poll()
+{
+    ncinput ni{};
+    return notcurses_get_nblock(nc, &ni);
+}
+
+namespace
+{
+    bool parseKey(const std::string &tok, uint32_t &key)
+    {
+        static const struct
+        {
+            const char *name;
+            uint32_t key;
+        } named[] = {
+            {"up", NCKEY_UP},
+            {"down", NCKEY_DOWN},
+            {"left", NCKEY_LEFT},
+            {"right", NCKEY_RIGHT},
+            {"enter", NCKEY_ENTER},
+            {"space", ' '},
+            {"backspace", 127},
+            {"esc", NCKEY_ESC},
+        };
+        for (const auto &n : named)
+        {
+            if (tok == n.name)
+            {
+                key = n.key;
+                return true;
+            }
+        }
+        if (tok.size() == 1)
+        {
+            key = static_cast<unsigned char>(tok[0]);
+            return true;
+        }
+        char *end = nullptr;
+        unsigned long v = std::strtoul(tok.c_str(), &end, 0);
+        if (end && *end == '\0' && v != 0)
+        {
+            key = static_cast<uint32_t>(v);
+            return true;
+        }
+        return false;
+    }
+}
+
+bool ScriptedInput::load(const std::string &path)
+{
+    std::ifstream in(path);
+    if (!in.good())
+        return false;
+    std::string line;
+    while (std::getline(in, line))
+    {
+        auto hash = line.find('#');
+        if (hash != std::string::npos)
+            line.erase(hash);
+        std::istringstream ls(line);
+        int64_t ms = 0;
+        std::string tok;
+        if (!(ls >> ms))
+            continue; // blank or comment-only line
+        if (!(ls >> tok))
+            return false;
+        uint32_t key = 0;
+        if (!parseKey(tok, key))
+            return false;
+        events.push_back({ms, key});
+    }
+    // Keep file order for equal timestamps
+    std::stable_sort(events.begin(), events.end(), [](const Event &a, const Event &b)
+                     { return a.ms < b.ms; });
+    return true;
+}
+
+uint32_t ScriptedInput::poll()
+{
+    auto now = clock.now();
+    if (!started)
+    {
+        start = now;
+        started = true;
+    }
+    if (exhausted())
+    {
+        if (quitWhenDone && !quitSent)
+        {
+            quitSent = true;
+            return 'q';
+        }
+        return 0u;
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - start).count();
+    if (events[next].ms > elapsed)
+        return 0u;
+    return events[next++].key;
+}
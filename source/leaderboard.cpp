@@ -0,0 +1,219 @@
+// Memory-mapped leaderboard shared between concurrently running instances
+#include "leaderboard.h"
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+    constexpr char kMagic[8] = {'B', 'H', 'L', 'E', 'A', 'D', 'E', 'R'};
+    constexpr uint32_t kVersion = 1;
+
+    struct Table
+    {
+        uint32_t count;
+        uint32_t pad;
+        LeaderboardEntry entries[Leaderboard::Capacity];
+    };
+
+    struct Header
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t capacity;
+        uint64_t state;       // (generation << 1) | current table
+        uint64_t writer;      // pid holding the update, 0 if none
+        uint64_t checksum[2]; // per table
+        uint8_t reserved[16];
+    };
+    static_assert(sizeof(Header) == 64, "header is an on-disk layout");
+
+    constexpr size_t kFileSize = sizeof(Header) + 2 * sizeof(Table);
+
+    Table *tables(void *base)
+    {
+        return reinterpret_cast<Table *>(static_cast<char *>(base) + sizeof(Header));
+    }
+
+    // FNV-1a over the table bytes
+    uint64_t checksum(const Table &t)
+    {
+        const unsigned char *p = reinterpret_cast<const unsigned char *>(&t);
+        uint64_t h = 1469598103934665603ull;
+        for (size_t i = 0; i < sizeof(Table); ++i)
+        {
+            h ^= p[i];
+            h *= 1099511628211ull;
+        }
+        return h;
+    }
+
+    bool valid(const Table &t, uint64_t sum)
+    {
+        return t.count <= (uint32_t)Leaderboard::Capacity && checksum(t) == sum;
+    }
+
+    bool headerOk(const Header *h)
+    {
+        return std::memcmp(h->magic, kMagic, sizeof kMagic) == 0 && h->version == kVersion &&
+               h->capacity == (uint32_t)Leaderboard::Capacity;
+    }
+
+    bool alive(uint64_t pid)
+    {
+        return kill((pid_t)pid, 0) == 0 || errno != ESRCH;
+    }
+}
+
+bool Leaderboard::open(const std::string &path)
+{
+    close();
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0)
+        return false;
+    // Only creation/repair takes the file lock; updates never do
+    flock(fd, LOCK_EX);
+    struct stat st{};
+    bool fresh = fstat(fd, &st) != 0 || (size_t)st.st_size != kFileSize;
+    if (fresh && ftruncate(fd, (off_t)kFileSize) != 0)
+    {
+        flock(fd, LOCK_UN);
+        ::close(fd);
+        return false;
+    }
+    void *p = mmap(nullptr, kFileSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (p == MAP_FAILED)
+    {
+        flock(fd, LOCK_UN);
+        ::close(fd);
+        return false;
+    }
+    Header *h = static_cast<Header *>(p);
+    if (fresh || !headerOk(h))
+    {
+        std::memset(p, 0, kFileSize);
+        Table *t = tables(p);
+        h->checksum[0] = checksum(t[0]);
+        h->checksum[1] = checksum(t[1]);
+        h->version = kVersion;
+        h->capacity = Capacity;
+        // Magic last: a half-initialised file is not mistaken for a good one
+        std::memcpy(h->magic, kMagic, sizeof kMagic);
+        msync(p, kFileSize, MS_SYNC);
+    }
+    flock(fd, LOCK_UN);
+    ::close(fd);
+
+    base = p;
+    mapSize = kFileSize;
+    return true;
+}
+
+void Leaderboard::close()
+{
+    if (!base)
+        return;
+    msync(base, mapSize, MS_ASYNC);
+    munmap(base, mapSize);
+    base = nullptr;
+    mapSize = 0;
+}
+
+uint64_t Leaderboard::generation() const
+{
+    if (!base)
+        return 0;
+    return __atomic_load_n(&static_cast<Header *>(base)->state, __ATOMIC_ACQUIRE) >> 1;
+}
+
+int Leaderboard::snapshot(LeaderboardEntry *out) const
+{
+    if (!base)
+        return 0;
+    Header *h = static_cast<Header *>(base);
+    const Table *t = tables(base);
+    // Seqlock-style read: retry if a writer published while we copied
+    for (int attempt = 0; attempt < 8; ++attempt)
+    {
+        uint64_t s = __atomic_load_n(&h->state, __ATOMIC_ACQUIRE);
+        int cur = (int)(s & 1);
+        Table copy;
+        std::memcpy(&copy, &t[cur], sizeof copy);
+        uint64_t sum = __atomic_load_n(&h->checksum[cur], __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&h->state, __ATOMIC_RELAXED) != s)
+            continue;
+        if (!valid(copy, sum))
+        {
+            // Damaged on disk: fall back to the previous table if it holds up
+            std::memcpy(&copy, &t[cur ^ 1], sizeof copy);
+            if (!valid(copy, h->checksum[cur ^ 1]))
+                return 0;
+        }
+        std::memcpy(out, copy.entries, copy.count * sizeof(LeaderboardEntry));
+        return (int)copy.count;
+    }
+    return 0;
+}
+
+bool Leaderboard::submit(const char *name, int score, uint64_t timeSec)
+{
+    if (!base)
+        return true;
+    Header *h = static_cast<Header *>(base);
+    Table *t = tables(base);
+
+    uint64_t self = (uint64_t)getpid();
+    uint64_t owner = 0;
+    if (!__atomic_compare_exchange_n(&h->writer, &owner, self, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+    {
+        // Held by a live instance: come back later. A dead holder (or a stale
+        // claim left under our own recycled pid) is taken over.
+        if (owner != self && (alive(owner) || !__atomic_compare_exchange_n(&h->writer, &owner, self, false,
+                                                                           __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)))
+            return false;
+    }
+
+    uint64_t s = __atomic_load_n(&h->state, __ATOMIC_ACQUIRE);
+    int cur = (int)(s & 1);
+    Table next;
+    std::memcpy(&next, &t[cur], sizeof next);
+    if (!valid(next, h->checksum[cur]))
+    {
+        std::memcpy(&next, &t[cur ^ 1], sizeof next);
+        if (!valid(next, h->checksum[cur ^ 1]))
+            std::memset(&next, 0, sizeof next);
+    }
+
+    // Ranked insert; equal scores keep the earlier entry first
+    int pos = 0;
+    while (pos < (int)next.count && next.entries[pos].score >= score)
+        ++pos;
+    if (pos < Capacity)
+    {
+        int last = std::min<int>((int)next.count, Capacity - 1);
+        for (int i = last; i > pos; --i)
+            next.entries[i] = next.entries[i - 1];
+        LeaderboardEntry e{};
+        e.score = score;
+        e.timeSec = timeSec;
+        std::strncpy(e.name, name, sizeof e.name - 1);
+        next.entries[pos] = e;
+        next.count = (uint32_t)std::min(Capacity, (int)next.count + 1);
+
+        std::memcpy(&t[cur ^ 1], &next, sizeof next);
+        __atomic_store_n(&h->checksum[cur ^ 1], checksum(next), __ATOMIC_RELAXED);
+        __atomic_store_n(&h->state, (((s >> 1) + 1) << 1) | (uint64_t)(cur ^ 1), __ATOMIC_RELEASE);
+        msync(base, mapSize, MS_ASYNC);
+    }
+
+    __atomic_store_n(&h->writer, 0, __ATOMIC_RELEASE);
+    return true;
+}
@@ -0,0 +1,349 @@
+// Level files: validation, atomic write, mapping
+#include "level.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+    constexpr char kMagic[8] = {'B', 'H', 'L', 'E', 'V', 'E', 'L', '\0'};
+    constexpr uint32_t kVersion = 1;
+    // Sides up to 65535 cells keep every cell index well inside size_t and
+    // the board still fits a Snake's Point coordinates
+    constexpr int kMaxSide = 65535;
+
+    bool bit(const uint64_t *mask, int width, int x, int y)
+    {
+        size_t i = (size_t)y * (size_t)width + (size_t)x;
+        return (mask[i >> 6] >> (i & 63)) & 1;
+    }
+
+    uint64_t fnv(uint64_t h, const void *data, size_t n)
+    {
+        const unsigned char *p = static_cast<const unsigned char *>(data);
+        for (size_t i = 0; i < n; ++i)
+        {
+            h ^= p[i];
+            h *= 1099511628211ull;
+        }
+        return h;
+    }
+}
+
+namespace level_file
+{
+    const char *check(int width, int height, const Point &spawn, const uint64_t *mask, const LevelPortal *portals,
+                      size_t portalCount)
+    {
+        if (width < 5 || height < 3 || width > kMaxSide || height > kMaxSide)
+            return "board must be 5x3 to 65535x65535";
+        for (int x = 0; x < width; ++x)
+            if (!bit(mask, width, x, 0) || !bit(mask, width, x, height - 1))
+                return "top and bottom rows must be wall";
+        for (int y = 1; y < height - 1; ++y)
+            if (!bit(mask, width, 0, y) || !bit(mask, width, width - 1, y))
+                return "left and right columns must be wall";
+        if (spawn.x < 3 || spawn.x > width - 2 || spawn.y < 1 || spawn.y > height - 2)
+            return "spawn must leave two free cells to its left inside the border";
+        for (int x = spawn.x - 2; x <= spawn.x; ++x)
+            if (bit(mask, width, x, spawn.y))
+                return "spawn and the two cells to its left must be free";
+        std::vector<size_t> ends;
+        ends.reserve(portalCount * 2);
+        for (size_t k = 0; k < portalCount; ++k)
+        {
+            const LevelPortal &p = portals[k];
+            for (const Point &e : {Point{p.ax, p.ay}, Point{p.bx, p.by}})
+            {
+                if (e.x < 1 || e.x > width - 2 || e.y < 1 || e.y > height - 2 || !bit(mask, width, e.x, e.y))
+                    return "portal ends must be wall cells off the border";
+                ends.push_back((size_t)e.y * (size_t)width + (size_t)e.x);
+            }
+        }
+        std::sort(ends.begin(), ends.end());
+        if (std::adjacent_find(ends.begin(), ends.end()) != ends.end())
+            return "a cell can be the end of one portal only";
+        return nullptr;
+    }
+
+    uint64_t idOf(int width, int height, const Point &spawn, const uint64_t *mask, Topology topology,
+                  const LevelPortal *portals, size_t portalCount)
+    {
+        int32_t shape[4] = {width, height, spawn.x, spawn.y};
+        uint64_t id = fnv(fnv(1469598103934665603ull, shape, sizeof shape), mask,
+                          maskWords(width, height) * sizeof(uint64_t));
+        if (topology != Topology::Walled || portalCount)
+        {
+            uint32_t layout[2] = {(uint32_t)topology, (uint32_t)portalCount};
+            id = fnv(fnv(id, layout, sizeof layout), portals, portalCount * sizeof(LevelPortal));
+        }
+        return id ? id : 1;
+    }
+
+    bool write(const std::string &path, int width, int height, const Point &spawn, const uint64_t *mask,
+               const char *name, Topology topology, const LevelPortal *portals, size_t portalCount)
+    {
+        if (check(width, height, spawn, mask, portals, portalCount))
+            return false;
+        size_t words = maskWords(width, height);
+        LevelHeader h{};
+        std::memcpy(h.magic, kMagic, sizeof kMagic);
+        h.version = kVersion;
+        h.headerSize = sizeof h;
+        h.width = width;
+        h.height = height;
+        h.spawnX = spawn.x;
+        h.spawnY = spawn.y;
+        h.maskOffset = sizeof h;
+        h.maskWords = words;
+        for (size_t i = 0; i < words; ++i)
+            h.wallCount += (uint64_t)__builtin_popcountll(mask[i]);
+        std::strncpy(h.name, name ? name : "", sizeof h.name - 1);
+        h.topology = (uint32_t)topology;
+        h.portalCount = (uint32_t)portalCount;
+        h.portalOffset = portalCount ? sizeof h + words * sizeof(uint64_t) : 0;
+        h.id = idOf(width, height, spawn, mask, topology, portals, portalCount);
+
+        std::string tmp = path + ".tmp";
+        int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0)
+            return false;
+        auto writeAll = [fd](const void *data, size_t left)
+        {
+            const char *p = static_cast<const char *>(data);
+            while (left > 0)
+            {
+                ssize_t n = ::write(fd, p, left);
+                if (n <= 0)
+                    return false;
+                p += n;
+                left -= (size_t)n;
+            }
+            return true;
+        };
+        bool ok = writeAll(&h, sizeof h) && writeAll(mask, words * sizeof(uint64_t)) &&
+                  writeAll(portals, portalCount * sizeof(LevelPortal));
+        ok = ok && fsync(fd) == 0;
+        ok = ::close(fd) == 0 && ok;
+        if (ok)
+            ok = std::rename(tmp.c_str(), path.c_str()) == 0;
+        if (!ok)
+            std::remove(tmp.c_str());
+        return ok;
+    }
+}
+
+Level &Level::operator=(Level &&o) noexcept
+{
+    if (this == &o)
+        return *this;
+    close();
+    base = o.base;
+    mapSize = o.mapSize;
+    owned = std::move(o.owned);
+    bits = o.bits;
+    w = o.w;
+    h = o.h;
+    start = o.start;
+    levelId = o.levelId;
+    gen = o.gen;
+    std::memcpy(levelName, o.levelName, sizeof levelName);
+    topo = o.topo;
+    portalList = std::move(o.portalList);
+    portalExits = std::move(o.portalExits);
+    links = std::move(o.links);
+    o.base = nullptr;
+    o.mapSize = 0;
+    o.bits = nullptr;
+    return *this;
+}
+
+Level Level::rectangle(int width, int height)
+{
+    Level l;
+    l.w = width;
+    l.h = height;
+    l.start = {width / 2, height / 2};
+    l.owned.assign(level_file::maskWords(width, height), 0);
+    uint64_t *m = l.owned.data();
+    for (int x = 0; x < width; ++x)
+    {
+        level_file::setWall(m, width, {x, 0});
+        level_file::setWall(m, width, {x, height - 1});
+    }
+    for (int y = 1; y < height - 1; ++y)
+    {
+        level_file::setWall(m, width, {0, y});
+        level_file::setWall(m, width, {width - 1, y});
+    }
+    l.bits = m;
+    l.link();
+    return l;
+}
+
+uint64_t *Level::draw(int width, int height)
+{
+    if (base)
+        munmap(base, mapSize);
+    base = nullptr;
+    mapSize = 0;
+    owned.assign(level_file::maskWords(width, height), 0);
+    bits = owned.data();
+    w = width;
+    h = height;
+    topo = Topology::Walled;
+    portalList.clear();
+    return owned.data();
+}
+
+void Level::commit(const Point &spawn, uint32_t generator)
+{
+    start = spawn;
+    gen = generator;
+    levelId = level_file::idOf(w, h, spawn, bits);
+    levelName[0] = '\0';
+    link();
+}
+
+bool Level::open(const std::string &path)
+{
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return false;
+    struct stat st{};
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(LevelHeader))
+    {
+        ::close(fd);
+        return false;
+    }
+    size_t size = (size_t)st.st_size;
+    void *p = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED)
+        return false;
+
+    // Only the header, the border and the spawn are looked at; the rest of
+    // the mask is paged in as the game touches it
+    const LevelHeader *lh = static_cast<const LevelHeader *>(p);
+    bool ok = std::memcmp(lh->magic, kMagic, sizeof kMagic) == 0 && lh->version == kVersion &&
+              lh->headerSize == sizeof(LevelHeader) && lh->width >= 5 && lh->height >= 3 &&
+              lh->width <= kMaxSide && lh->height <= kMaxSide &&
+              lh->maskWords == level_file::maskWords(lh->width, lh->height) && lh->maskOffset % 8 == 0 &&
+              lh->maskOffset >= sizeof(LevelHeader) && lh->maskOffset <= size &&
+              (size - lh->maskOffset) / sizeof(uint64_t) >= lh->maskWords && lh->id != 0 &&
+              lh->topology <= (uint32_t)Topology::Torus &&
+              (lh->portalCount == 0 || (lh->portalOffset % 8 == 0 && lh->portalOffset >= sizeof(LevelHeader) &&
+                                        lh->portalOffset <= size &&
+                                        (size - lh->portalOffset) / sizeof(LevelPortal) >= lh->portalCount));
+    const uint64_t *m = ok ? reinterpret_cast<const uint64_t *>(static_cast<const char *>(p) + lh->maskOffset)
+                           : nullptr;
+    const LevelPortal *portals =
+        ok && lh->portalCount
+            ? reinterpret_cast<const LevelPortal *>(static_cast<const char *>(p) + lh->portalOffset)
+            : nullptr;
+    if (!ok || level_file::check(lh->width, lh->height, {lh->spawnX, lh->spawnY}, m, portals, lh->portalCount))
+    {
+        munmap(p, size);
+        return false;
+    }
+    base = p;
+    mapSize = size;
+    bits = m;
+    w = lh->width;
+    h = lh->height;
+    start = {lh->spawnX, lh->spawnY};
+    levelId = lh->id;
+    std::memcpy(levelName, lh->name, sizeof levelName);
+    levelName[sizeof levelName - 1] = '\0';
+    topo = (Topology)lh->topology;
+    portalList.assign(portals, portals + lh->portalCount);
+    link();
+    return true;
+}
+
+void Level::close()
+{
+    if (base)
+        munmap(base, mapSize);
+    base = nullptr;
+    mapSize = 0;
+    owned.clear();
+    bits = nullptr;
+    w = h = 0;
+    start = {0, 0};
+    levelId = 0;
+    gen = 0;
+    levelName[0] = '\0';
+    topo = Topology::Walled;
+    portalList.clear();
+    portalExits.clear();
+    links.clear();
+}
+
+uint32_t Level::linkOf(const Point &from, Direction d) const
+{
+    Point p = neighbour(from, d);
+    if (wall(p))
+    {
+        // Across the torus seam onto the first cell inside the opposite
+        // border, or out of the other end of a portal
+        if (topo == Topology::Torus && (p.x == 0 || p.y == 0 || p.x == w - 1 || p.y == h - 1))
+            p = {p.x == 0 ? w - 2 : p.x == w - 1 ? 1 : p.x, p.y == 0 ? h - 2 : p.y == h - 1 ? 1 : p.y};
+        else
+        {
+            size_t i = (size_t)p.y * (size_t)w + (size_t)p.x;
+            auto it = std::lower_bound(portalExits.begin(), portalExits.end(), i,
+                                       [](const std::pair<size_t, Point> &e, size_t c) { return e.first < c; });
+            if (it == portalExits.end() || it->first != i)
+                return kNoLink;
+            p = neighbour(it->second, d);
+        }
+        if (wall(p))
+            return kNoLink;
+    }
+    return (uint32_t)p.y << 16 | (uint32_t)p.x;
+}
+
+void Level::link()
+{
+    portalExits.clear();
+    for (const LevelPortal &p : portalList)
+    {
+        portalExits.push_back({(size_t)p.ay * (size_t)w + (size_t)p.ax, Point{p.bx, p.by}});
+        portalExits.push_back({(size_t)p.by * (size_t)w + (size_t)p.bx, Point{p.ax, p.ay}});
+    }
+    std::sort(portalExits.begin(), portalExits.end(),
+              [](const std::pair<size_t, Point> &a, const std::pair<size_t, Point> &b) { return a.first < b.first; });
+
+    size_t cells = (size_t)w * (size_t)h;
+    if (cells > kLinkedCells)
+    {
+        std::vector<uint32_t>().swap(links);
+        return;
+    }
+    // Same size as the last board (a new generated one each game): no allocation
+    links.resize(cells * 4);
+    uint32_t *out = links.data();
+    for (int y = 0; y < h; ++y)
+        for (int x = 0; x < w; ++x, out += 4)
+        {
+            if (wall({x, y}))
+            {
+                out[0] = out[1] = out[2] = out[3] = kNoLink;
+                continue;
+            }
+            // Free neighbours link straight to themselves; only walls need
+            // the seam and portal lookups
+            for (int d = 0; d < 4; ++d)
+            {
+                Point p = neighbour({x, y}, (Direction)d);
+                out[d] = wall(p) ? linkOf({x, y}, (Direction)d) : (uint32_t)p.y << 16 | (uint32_t)p.x;
+            }
+        }
+}
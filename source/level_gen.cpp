@@ -0,0 +1,283 @@
+// Level generator: Kruskal mazes, rooms and corridors, scattered blocks,
+// and the flood fill that keeps every free cell reachable
+#include "level_gen.h"
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+    inline size_t at(int w, int x, int y) { return (size_t)y * (size_t)w + (size_t)x; }
+    inline bool isWall(const uint64_t *m, size_t i) { return (m[i >> 6] >> (i & 63)) & 1; }
+    inline void setWall(uint64_t *m, size_t i) { m[i >> 6] |= 1ull << (i & 63); }
+    inline void setFree(uint64_t *m, size_t i) { m[i >> 6] &= ~(1ull << (i & 63)); }
+
+    // Bits past the last cell stay clear, so popcounts count cells
+    void trim(uint64_t *m, int w, int h)
+    {
+        size_t cells = (size_t)w * (size_t)h;
+        if (cells % 64)
+            m[level_file::maskWords(w, h) - 1] &= (1ull << (cells % 64)) - 1;
+    }
+
+    void allWall(uint64_t *m, int w, int h)
+    {
+        std::memset(m, 0xff, level_file::maskWords(w, h) * sizeof(uint64_t));
+        trim(m, w, h);
+    }
+
+    void border(uint64_t *m, int w, int h)
+    {
+        for (int x = 0; x < w; ++x)
+        {
+            setWall(m, at(w, x, 0));
+            setWall(m, at(w, x, h - 1));
+        }
+        for (int y = 1; y < h - 1; ++y)
+        {
+            setWall(m, at(w, 0, y));
+            setWall(m, at(w, w - 1, y));
+        }
+    }
+
+    void carve(uint64_t *m, int w, int x0, int y0, int x1, int y1)
+    {
+        if (x0 > x1)
+            std::swap(x0, x1);
+        if (y0 > y1)
+            std::swap(y0, y1);
+        for (int y = y0; y <= y1; ++y)
+            for (int x = x0; x <= x1; ++x)
+                setFree(m, at(w, x, y));
+    }
+}
+
+bool parseLevelStyle(const char *s, LevelStyle &out)
+{
+    for (LevelStyle l : {LevelStyle::Maze, LevelStyle::Rooms, LevelStyle::Blocks})
+        if (std::strcmp(s, levelStyleName(l)) == 0)
+        {
+            out = l;
+            return true;
+        }
+    return false;
+}
+
+const char *levelStyleName(LevelStyle s)
+{
+    switch (s)
+    {
+    case LevelStyle::Maze:
+        return "maze";
+    case LevelStyle::Rooms:
+        return "rooms";
+    case LevelStyle::Blocks:
+        return "blocks";
+    }
+    return "?";
+}
+
+bool LevelGenerator::generate(LevelStyle style, int width, int height, uint64_t seed, Level &out)
+{
+    if (width < 5 || height < 3 || width > 65535 || height > 65535)
+        return false;
+    if (style != LevelStyle::Maze && style != LevelStyle::Rooms && style != LevelStyle::Blocks)
+        return false;
+    rng = seed;
+    uint64_t *m = out.draw(width, height);
+    Point spawn{width / 2, height / 2};
+    if (width < 7 || height < 5)
+    {
+        // Two free cells behind the head even on a 5-wide board
+        border(m, width, height);
+        spawn.x = std::max(3, spawn.x);
+    }
+    else if (style == LevelStyle::Maze)
+        maze(m, width, height, spawn);
+    else if (style == LevelStyle::Rooms)
+        rooms(m, width, height, spawn);
+    else
+        blocks(m, width, height, spawn);
+
+    // Wall up whatever the layout cut off from the spawn
+    fill(m, width, height, spawn);
+    size_t words = level_file::maskWords(width, height);
+    for (size_t i = 0; i < words; ++i)
+        m[i] |= ~seen[i];
+    trim(m, width, height);
+    out.commit(spawn, (uint32_t)style);
+    return true;
+}
+
+void LevelGenerator::maze(uint64_t *m, int w, int h, Point &spawn)
+{
+    // Lattice cells at odd coordinates; an edge opens the wall between two
+    // neighbours. Kruskal over shuffled edges gives a spanning tree, and a
+    // few edges that would close a cycle are opened anyway.
+    allWall(m, w, h);
+    uint32_t cx = (uint32_t)(w - 1) / 2, cy = (uint32_t)(h - 1) / 2;
+    uint32_t n = cx * cy;
+    parent.resize(n);
+    edges.clear();
+    for (uint32_t j = 0; j < cy; ++j)
+        for (uint32_t i = 0; i < cx; ++i)
+        {
+            uint32_t c = j * cx + i;
+            parent[c] = c;
+            setFree(m, at(w, (int)(2 * i + 1), (int)(2 * j + 1)));
+            if (i + 1 < cx)
+                edges.push_back(c << 1);
+            if (j + 1 < cy)
+                edges.push_back(c << 1 | 1);
+        }
+    for (size_t k = edges.size(); k > 1; --k)
+        std::swap(edges[k - 1], edges[below((uint32_t)k)]);
+
+    auto find = [&](uint32_t c)
+    {
+        while (parent[c] != c)
+        {
+            parent[c] = parent[parent[c]];
+            c = parent[c];
+        }
+        return c;
+    };
+    auto open = [&](uint32_t e)
+    {
+        uint32_t c = e >> 1;
+        int x = (int)(2 * (c % cx) + 1), y = (int)(2 * (c / cx) + 1);
+        setFree(m, (e & 1) ? at(w, x, y + 1) : at(w, x + 1, y));
+    };
+    auto join = [&](uint32_t e)
+    {
+        uint32_t a = e >> 1, b = (e & 1) ? a + cx : a + 1;
+        uint32_t ra = find(a), rb = find(b);
+        if (ra == rb)
+            return false;
+        parent[ra] = rb;
+        open(e);
+        return true;
+    };
+
+    // The spawn sits in a straight corridor: open to the left for the body
+    // and to the right for the first move
+    uint32_t si = cx / 2, sj = cy / 2, s = sj * cx + si;
+    join((s - 1) << 1);
+    join(s << 1);
+    spawn = {(int)(2 * si + 1), (int)(2 * sj + 1)};
+
+    for (uint32_t e : edges)
+        if (!join(e) && below(100) < 8)
+            open(e);
+}
+
+void LevelGenerator::rooms(uint64_t *m, int w, int h, Point &spawn)
+{
+    // One room per tile of about 18x12 cells, visited row by row in a
+    // serpentine so each room is joined to a neighbour's by a short L-shaped
+    // corridor; the spawn's small room is joined to the nearest room last
+    allWall(m, w, h);
+    int tx = std::max(1, (w - 2) / 18), ty = std::max(1, (h - 2) / 12);
+    Point prev{-1, -1}, near{-1, -1};
+    spawn = {w / 2, h / 2};
+    auto corridor = [&](const Point &a, const Point &b)
+    {
+        if (below(2))
+        {
+            carve(m, w, a.x, a.y, b.x, a.y);
+            carve(m, w, b.x, a.y, b.x, b.y);
+        }
+        else
+        {
+            carve(m, w, a.x, a.y, a.x, b.y);
+            carve(m, w, a.x, b.y, b.x, b.y);
+        }
+    };
+    for (int j = 0; j < ty; ++j)
+        for (int k = 0; k < tx; ++k)
+        {
+            int i = (j & 1) ? tx - 1 - k : k;
+            int x0 = 1 + i * (w - 2) / tx, x1 = 1 + (i + 1) * (w - 2) / tx;
+            int y0 = 1 + j * (h - 2) / ty, y1 = 1 + (j + 1) * (h - 2) / ty;
+            int rw = 3 + (int)below((uint32_t)(std::min(14, x1 - x0 - 1) - 3 + 1));
+            int rh = 2 + (int)below((uint32_t)(std::min(8, y1 - y0 - 1) - 2 + 1));
+            int rx = x0 + (int)below((uint32_t)(x1 - x0 - rw + 1));
+            int ry = y0 + (int)below((uint32_t)(y1 - y0 - rh + 1));
+            carve(m, w, rx, ry, rx + rw - 1, ry + rh - 1);
+            Point c{rx + rw / 2, ry + rh / 2};
+            if (prev.x >= 0)
+                corridor(prev, c);
+            prev = c;
+            if (spawn.x >= x0 && spawn.x < x1 && spawn.y >= y0 && spawn.y < y1)
+                near = c;
+        }
+    carve(m, w, std::max(1, spawn.x - 3), spawn.y, std::min(w - 2, spawn.x + 3), spawn.y);
+    corridor(spawn, near);
+}
+
+void LevelGenerator::blocks(uint64_t *m, int w, int h, Point &spawn)
+{
+    // About one block per 24 cells, 1x1 to 3x2, then a clear run for the
+    // start; blocks can seal off pockets, which the fill then walls up
+    border(m, w, h);
+    int count = (w - 2) * (h - 2) / 24;
+    for (int k = 0; k < count; ++k)
+    {
+        int bw = 1 + (int)below(3), bh = 1 + (int)below(2);
+        int x0 = 1 + (int)below((uint32_t)(w - 2)), y0 = 1 + (int)below((uint32_t)(h - 2));
+        for (int y = y0; y < std::min(y0 + bh, h - 1); ++y)
+            for (int x = x0; x < std::min(x0 + bw, w - 1); ++x)
+                setWall(m, at(w, x, y));
+    }
+    spawn = {w / 2, h / 2};
+    carve(m, w, spawn.x - 2, spawn.y, spawn.x + 2, spawn.y);
+}
+
+size_t LevelGenerator::fill(const uint64_t *m, int w, int h, const Point &spawn)
+{
+    size_t cells = (size_t)w * (size_t)h;
+    seen.assign(level_file::maskWords(w, h), 0);
+    if (queue.size() < cells)
+        queue.resize(cells);
+    size_t head = 0, tail = 0;
+    size_t s = at(w, spawn.x, spawn.y);
+    if (isWall(m, s))
+        return 0;
+    setWall(seen.data(), s);
+    queue[tail++] = (uint32_t)s;
+    // The border is wall, so a free cell's four neighbours are all on the board
+    const size_t step[4] = {1, (size_t)-1, (size_t)w, (size_t)-w};
+    while (head < tail)
+    {
+        size_t i = queue[head++];
+        for (size_t d : step)
+        {
+            size_t j = i + d;
+            if (!isWall(m, j) && !isWall(seen.data(), j))
+            {
+                setWall(seen.data(), j);
+                queue[tail++] = (uint32_t)j;
+            }
+        }
+    }
+    return tail;
+}
+
+size_t LevelGenerator::reachable(const Level &level)
+{
+    return fill(level.mask(), level.width(), level.height(), level.spawn());
+}
+
+size_t LevelGenerator::freeCells(const Level &level)
+{
+    size_t cells = (size_t)level.width() * (size_t)level.height();
+    size_t words = level_file::maskWords(level.width(), level.height());
+    size_t walls = 0;
+    for (size_t i = 0; i < words; ++i)
+    {
+        uint64_t v = level.mask()[i];
+        if (i + 1 == words && cells % 64)
+            v &= (1ull << (cells % 64)) - 1;
+        walls += (size_t)__builtin_popcountll(v);
+    }
+    return cells - walls;
+}
@@ -1,14 +1,258 @@
 #include <iostream>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
 #include "game.h"
+#include "trace.h"
+#include "metrics.h"
+#include "replay.h"
 
-int main()
+namespace
+{
+    void usage(const char *argv0)
+    {
+        std::cerr << "usage: " << argv0 << " [--script FILE] [--seed N] [--headless] [--stats-file FILE] [--trace FILE] [--metrics FILE] [--practice] [--cast FILE]\n"
+                  << "              [--level FILE | --generate maze|rooms|blocks]\n"
+                  << "       " << argv0 << " --replay FILE [--fast] [--cast FILE] [--level FILE]\n"
+                  << "       " << argv0 << " --replay FILE --cast FILE --headless\n"
+                  << "       " << argv0 << " --dump-flight FILE | --history [N]\n"
+                  << "  --script FILE  play keys from FILE on a virtual clock (full CPU speed)\n"
+                  << "  --seed N       fixed fruit seed for reproducible sessions\n"
+                  << "  --headless     no terminal output (requires --script, or --replay and --cast)\n"
+                  << "  --stats-file F dump frame-time histograms to F on exit\n"
+                  << "  --trace FILE   write Chrome trace-event JSON (build with make TRACE=1)\n"
+                  << "  --metrics FILE rewrite FILE every 5 s with Prometheus metrics\n"
+                  << "  --flight FILE  flight recorder ring (default flight.rec, \"\" disables)\n"
+                  << "  --practice     'b' rewinds ~3 s, even after dying; scores aren't kept\n"
+                  << "  --replay FILE  play back a recorded game (--fast: no tick delay)\n"
+                  << "  --level FILE   play on a level file (make one with tools/level_tool); a\n"
+                  << "                 replay recorded on a level needs the same one\n"
+                  << "  --generate STYLE  a new generated board every game, from the fruit seed\n"
+                  << "  --cast FILE    record the terminal output as an asciicast v2 file; with\n"
+                  << "                 --headless, draw offscreen at full speed instead\n"
+                  << "  --dump-flight FILE  print a flight recorder file and exit\n"
+                  << "  --history [N]  print totals, the top N scores (default 10) and recent games,\n"
+                  << "                 then exit\n";
+    }
+
+    // Stops the trace writer and the metrics exporter on every way out of
+    // main, the error returns included: exit with either thread still
+    // joinable aborts
+    struct StopExporters
+    {
+        ~StopExporters()
+        {
+            trace::stop();
+            metrics_export::stop();
+        }
+    };
+}
+
+int main(int argc, char **argv)
 {
     // Grid size (including walls). Playable area is (width-2) x (height-2)
     // Increased default board: m x n where m>n
     const int width = 80;  // m (horizontal)
     const int height = 30; // n (vertical)
+
+    const char *scriptPath = nullptr;
+    const char *seedArg = nullptr;
+    const char *statsPath = nullptr;
+    const char *tracePath = nullptr;
+    const char *metricsPath = nullptr;
+    const char *flightPath = nullptr;
+    const char *replayPath = nullptr;
+    const char *castPath = nullptr;
+    const char *levelPath = nullptr;
+    const char *styleArg = nullptr;
+    bool headless = false;
+    bool fast = false;
+    bool practice = false;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--script") == 0 && i + 1 < argc)
+            scriptPath = argv[++i];
+        else if (std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+            seedArg = argv[++i];
+        else if (std::strcmp(argv[i], "--stats-file") == 0 && i + 1 < argc)
+            statsPath = argv[++i];
+        else if (std::strcmp(argv[i], "--trace") == 0 && i + 1 < argc)
+            tracePath = argv[++i];
+        else if (std::strcmp(argv[i], "--metrics") == 0 && i + 1 < argc)
+            metricsPath = argv[++i];
+        else if (std::strcmp(argv[i], "--flight") == 0 && i + 1 < argc)
+            flightPath = argv[++i];
+        else if (std::strcmp(argv[i], "--replay") == 0 && i + 1 < argc)
+            replayPath = argv[++i];
+        else if (std::strcmp(argv[i], "--cast") == 0 && i + 1 < argc)
+            castPath = argv[++i];
+        else if (std::strcmp(argv[i], "--level") == 0 && i + 1 < argc)
+            levelPath = argv[++i];
+        else if (std::strcmp(argv[i], "--generate") == 0 && i + 1 < argc)
+            styleArg = argv[++i];
+        else if (std::strcmp(argv[i], "--fast") == 0)
+            fast = true;
+        else if (std::strcmp(argv[i], "--practice") == 0)
+            practice = true;
+        else if (std::strcmp(argv[i], "--dump-flight") == 0 && i + 1 < argc)
+        {
+            if (!FlightRecorder::dump(argv[i + 1], std::cout))
+            {
+                std::cerr << "not a flight recorder file: " << argv[i + 1] << "\n";
+                return 1;
+            }
+            return 0;
+        }
+        else if (std::strcmp(argv[i], "--history") == 0)
+        {
+            size_t top = ScoreJournal::TopK;
+            if (i + 1 < argc && std::isdigit((unsigned char)argv[i + 1][0]))
+                top = std::strtoull(argv[i + 1], nullptr, 10);
+            if (!ScoreJournal::dump("scores", std::cout, top))
+            {
+                std::cerr << "no score history in this directory\n";
+                return 1;
+            }
+            return 0;
+        }
+        else if (std::strcmp(argv[i], "--headless") == 0)
+            headless = true;
+        else
+        {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    LevelStyle style{};
+    if ((headless && !scriptPath && !(replayPath && castPath)) ||
+        (styleArg && (levelPath || replayPath || !parseLevelStyle(styleArg, style))))
+    {
+        usage(argv[0]);
+        return 2;
+    }
+
+    StopExporters stopExporters;
+    if (tracePath)
+    {
+        if (!BYTEHEBI_TRACE)
+            std::cerr << "warning: built without tracing (make TRACE=1); --trace ignored\n";
+        else if (!trace::start(tracePath))
+        {
+            std::cerr << "cannot open trace file: " << tracePath << "\n";
+            return 1;
+        }
+    }
+
+    if (metricsPath)
+        metrics_export::start(metricsPath);
+
+    if (replayPath)
+    {
+        if (scriptPath || seedArg || practice || (headless && fast))
+        {
+            usage(argv[0]);
+            return 2;
+        }
+        Replay replay;
+        if (!replay.open(replayPath))
+        {
+            std::cerr << "not a replay file: " << replayPath << "\n";
+            return 1;
+        }
+        // The replay decides the board, seed and tick rate
+        Game game(replay.header().width, replay.header().height);
+        if (levelPath && !game.loadLevel(levelPath))
+        {
+            std::cerr << "not a level file: " << levelPath << "\n";
+            return 1;
+        }
+        else if (!levelPath)
+        {
+            // A generated board is rebuilt from the header
+            Level board;
+            if (replayBoard(replay.header(), board))
+                game.setLevel(std::move(board));
+        }
+        if (!game.setReplay(replay, fast))
+        {
+            std::cerr << "the replay was recorded on another level; pass that one with --level\n";
+            return 1;
+        }
+        if (statsPath)
+            game.setStatsFile(statsPath);
+        if (flightPath)
+            game.setFlightRecorderFile(flightPath);
+        // Offline export: virtual time at the recorded rate, then two
+        // seconds of the game-over screen
+        VirtualClock clock;
+        ScriptedInput keys(clock);
+        if (headless)
+        {
+            keys.quitWhenDone = false;
+            keys.push((int64_t)(replay.header().ticks * (uint64_t)replay.header().tickMs) + 2000, 'q');
+            game.setClock(clock);
+            game.setInputSource(keys);
+        }
+        if (castPath)
+            game.setCastFile(castPath, headless);
+        int score = game.run();
+        trace::stop();
+        metrics_export::stop();
+        std::cout << "replay score " << score << " (recorded " << replay.header().score << ")\n";
+        return 0;
+    }
+
     // Game will prompt for player name in an in-game dialog on startup
     Game game(width, height);
-    game.run();
+    if (levelPath && !game.loadLevel(levelPath))
+    {
+        std::cerr << "not a level file: " << levelPath << "\n";
+        return 1;
+    }
+    if (seedArg)
+        game.setSeed(static_cast<unsigned>(std::strtoul(seedArg, nullptr, 0)));
+    if (styleArg)
+        game.setLevelStyle(style);
+    if (statsPath)
+        game.setStatsFile(statsPath);
+    if (flightPath)
+        game.setFlightRecorderFile(flightPath);
+    if (practice)
+        game.setPracticeMode(true);
+
+    if (!scriptPath)
+    {
+        if (castPath)
+            game.setCastFile(castPath);
+        game.run();
+        trace::stop();
+        metrics_export::stop();
+        return 0;
+    }
+
+    // Scripted session: virtual time, so it runs as fast as the CPU allows
+    VirtualClock clock;
+    ScriptedInput script(clock);
+    if (!script.load(scriptPath))
+    {
+        std::cerr << "cannot load script: " << scriptPath << "\n";
+        return 1;
+    }
+    game.setClock(clock);
+    game.setInputSource(script);
+    // Scripts replay from a fresh game and leave nothing behind: no save,
+    // leaderboard entry, history record or replay
+    game.setSaveFile("");
+    game.setLeaderboardFile("");
+    game.setHistoryFile("");
+    game.setReplayDir("");
+    // Headless with a cast still draws, into an offscreen terminal
+    game.setHeadless(headless && !castPath);
+    if (castPath)
+        game.setCastFile(castPath, headless);
+    int score = game.run();
+    trace::stop();
+    metrics_export::stop();
+    std::cout << score << "\n";
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,118 @@
+// Metrics exporter thread
+#include "metrics.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+#include <unistd.h>
+
+Metrics &metrics()
+{
+    static Metrics m;
+    return m;
+}
+
+namespace
+{
+    std::thread g_thread;
+    std::mutex g_mu;
+    std::condition_variable g_cv;
+    bool g_running = false;
+    bool g_stop = false;
+
+    uint64_t residentBytes()
+    {
+        FILE *f = std::fopen("/proc/self/statm", "r");
+        if (!f)
+            return 0;
+        unsigned long size = 0, resident = 0;
+        int n = std::fscanf(f, "%lu %lu", &size, &resident);
+        std::fclose(f);
+        if (n != 2)
+            return 0;
+        return (uint64_t)resident * (uint64_t)sysconf(_SC_PAGESIZE);
+    }
+
+    void writeFile(const std::string &path)
+    {
+        std::string body = metrics_export::render();
+        std::string tmp = path + ".tmp";
+        FILE *f = std::fopen(tmp.c_str(), "w");
+        if (!f)
+            return;
+        bool ok = std::fwrite(body.data(), 1, body.size(), f) == body.size();
+        ok = (std::fclose(f) == 0) && ok;
+        if (ok)
+            std::rename(tmp.c_str(), path.c_str());
+        else
+            std::remove(tmp.c_str());
+    }
+}
+
+namespace metrics_export
+{
+    std::string render()
+    {
+        const Metrics &m = metrics();
+        auto ld = [](const auto &a)
+        { return a.load(std::memory_order_relaxed); };
+        std::ostringstream out;
+        auto metric = [&](const char *name, const char *type, const char *help, auto value)
+        {
+            out << "# HELP " << name << " " << help << "\n"
+                << "# TYPE " << name << " " << type << "\n"
+                << name << " " << value << "\n";
+        };
+        metric("bytehebi_ticks_total", "counter", "Simulation ticks executed.", ld(m.ticks));
+        metric("bytehebi_frames_total", "counter", "Frames rendered.", ld(m.frames));
+        metric("bytehebi_input_events_total", "counter", "Key events processed.", ld(m.inputEvents));
+        metric("bytehebi_terminal_bytes_total", "counter", "Bytes written to the terminal by Notcurses.", ld(m.terminalBytes));
+        metric("bytehebi_tick_jitter_seconds", "gauge", "Last tick interval minus the configured tick length.", (double)ld(m.tickJitterNs) / 1e9);
+        metric("bytehebi_render_seconds", "gauge", "Last frame's render + notcurses_render time.", (double)ld(m.renderNs) / 1e9);
+        metric("bytehebi_snake_length", "gauge", "Current snake length in cells.", ld(m.snakeLength));
+        metric("bytehebi_resident_memory_bytes", "gauge", "Resident set size.", residentBytes());
+        return out.str();
+    }
+
+    bool start(const std::string &path, int intervalMs)
+    {
+        std::lock_guard<std::mutex> lk(g_mu);
+        if (g_running)
+            return false;
+        g_running = true;
+        g_stop = false;
+        g_thread = std::thread([path, intervalMs]
+                               {
+            std::unique_lock<std::mutex> lk(g_mu);
+            while (true)
+            {
+                bool stopping = g_cv.wait_for(lk, std::chrono::milliseconds(intervalMs), []
+                                              { return g_stop; });
+                lk.unlock();
+                writeFile(path);
+                Metrics &m = metrics();
+                m.set(m.wantTerminalStats, true);
+                lk.lock();
+                if (stopping)
+                    break;
+            } });
+        return true;
+    }
+
+    void stop()
+    {
+        {
+            std::lock_guard<std::mutex> lk(g_mu);
+            if (!g_running)
+                return;
+            g_stop = true;
+        }
+        g_cv.notify_one();
+        g_thread.join();
+        std::lock_guard<std::mutex> lk(g_mu);
+        g_running = false;
+    }
+}
@@ -0,0 +1,285 @@
+// Replay recording, mapping and turn decoding
+#include "replay.h"
+#include "level_gen.h"
+#include <algorithm>
+#include <cstring>
+#include <ctime>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace
+{
+    constexpr char kMagic[8] = {'B', 'H', 'R', 'E', 'P', 'L', 'A', 'Y'};
+    constexpr uint32_t kVersion = 1;
+}
+
+ReplayHeader newReplayHeader(int width, int height, int tickMs, unsigned seed, uint64_t level)
+{
+    ReplayHeader h{};
+    std::memcpy(h.magic, kMagic, sizeof kMagic);
+    h.version = kVersion;
+    h.headerSize = sizeof h;
+    h.width = width;
+    h.height = height;
+    h.tickMs = tickMs;
+    h.seed = seed;
+    h.level = level;
+    return h;
+}
+
+bool replayBoard(const ReplayHeader &h, Level &out)
+{
+    if (h.generator)
+    {
+        LevelGenerator gen;
+        return gen.generate((LevelStyle)h.generator, h.width, h.height, h.seed, out) && out.id() == h.level;
+    }
+    if (h.level != 0 || h.width < 4 || h.height < 4 || h.width > 65535 || h.height > 65535)
+        return false;
+    out = Level::rectangle(h.width, h.height);
+    return true;
+}
+
+void ReplayWriter::begin(const Level &level, int tickMs, unsigned seed)
+{
+    header = newReplayHeader(level.width(), level.height(), tickMs, seed, level.id());
+    header.generator = level.generator();
+    turnBytes.clear();
+    lastTick = 0;
+    last = Direction::Right;
+}
+
+bool ReplayWriter::save(const char *path, uint64_t ticks, int score, uint32_t length, const char *name) const
+{
+    ReplayHeader h = header;
+    h.ticks = ticks;
+    h.timeSec = (uint64_t)std::time(nullptr);
+    h.score = score;
+    h.length = length;
+    std::strncpy(h.name, name, sizeof h.name - 1);
+
+    int fd = ::open(path, O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    if (fd < 0)
+        return false;
+    iovec iov[2] = {{&h, sizeof h}, {const_cast<uint8_t *>(turnBytes.data()), turnBytes.size()}};
+    ssize_t want = (ssize_t)(sizeof h + turnBytes.size());
+    bool ok = writev(fd, iov, 2) == want;
+    ok = ::close(fd) == 0 && ok;
+    if (!ok)
+        unlink(path);
+    return ok;
+}
+
+bool Replay::open(const std::string &path)
+{
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return false;
+    struct stat st{};
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(ReplayHeader))
+    {
+        ::close(fd);
+        return false;
+    }
+    size_t size = (size_t)st.st_size;
+    void *p = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED)
+        return false;
+
+    const ReplayHeader *h = static_cast<const ReplayHeader *>(p);
+    if (std::memcmp(h->magic, kMagic, sizeof kMagic) != 0 || h->version != kVersion ||
+        h->headerSize != sizeof(ReplayHeader) || h->width < 4 || h->height < 4 || h->tickMs <= 0)
+    {
+        munmap(p, size);
+        return false;
+    }
+    base = p;
+    mapSize = size;
+    return true;
+}
+
+void Replay::close()
+{
+    if (!base)
+        return;
+    munmap(base, mapSize);
+    base = nullptr;
+    mapSize = 0;
+}
+
+void ReplayCursor::reset(const uint8_t *turns, size_t bytes)
+{
+    p = turns;
+    end = turns + bytes;
+    nextTick = 0;
+    decode();
+}
+
+void ReplayCursor::decode()
+{
+    // A truncated varint ends the turns
+    uint64_t v = 0;
+    int shift = 0;
+    pending = false;
+    while (p < end && shift < 64)
+    {
+        uint8_t b = *p++;
+        v |= (uint64_t)(b & 0x7f) << shift;
+        if (!(b & 0x80))
+        {
+            nextTick += v >> 2;
+            nextDir = (Direction)(v & 3);
+            pending = true;
+            return;
+        }
+        shift += 7;
+    }
+    p = end;
+}
+
+void replayStart(const Replay &r, const Level &level, Snake &snake, Fruit &fruit, ReplayCursor &cursor)
+{
+    const ReplayHeader &h = r.header();
+    snake.reset(level.spawn().x, level.spawn().y, 3);
+    fruit.reseed(h.seed);
+    fruit.respawn([&](const Point &p)
+                  { return snake.contains(p) || level.wall(p); });
+    cursor = ReplayCursor(r);
+}
+
+ReplayCheck checkReplay(const ReplayHeader &h, const Level &level, const uint8_t *turns, size_t bytes)
+{
+    ReplayCheck c;
+    if (h.width < 4 || h.height < 4 || !levelMatches(h, level))
+        return c;
+    c.valid = true;
+
+    Snake snake(level.spawn().x, level.spawn().y, 3, (size_t)h.width * (size_t)h.height);
+    Fruit fruit(h.width, h.height, h.seed);
+    fruit.respawn([&](const Point &p)
+                  { return snake.contains(p) || level.wall(p); });
+    ReplayCursor cursor;
+    cursor.reset(turns, bytes);
+    ReplayLoop loop;
+    for (uint64_t tick = 1;; ++tick)
+    {
+        // A game that outlives its claimed end can't match; stop rather
+        // than follow a snake that may never die
+        if (tick > h.ticks)
+        {
+            c.ticks = tick;
+            c.alive = true;
+            break;
+        }
+        Direction d;
+        bool turned = cursor.turnAt(tick, d);
+        if (turned)
+            snake.setDirection(d);
+        StepResult s = stepRules(level, snake, fruit, c.score);
+        if (isDeath(s))
+        {
+            c.ticks = tick;
+            break;
+        }
+        if (!loop.step(tick, snake, turned || s == StepResult::Grew))
+            continue;
+        // Going round in circles: with no turn to come (or only one stuck
+        // behind an earlier tick) it never ends; otherwise skip whole laps
+        // up to the turn instead of walking a gap the header may make huge
+        uint64_t next = cursor.nextTurn();
+        if (next <= tick || cursor.done())
+        {
+            c.ticks = tick;
+            c.alive = true;
+            break;
+        }
+        uint64_t last = std::min(next - 1, h.ticks);
+        tick += (last - tick) / loop.period() * loop.period();
+        loop.reset();
+    }
+    c.length = (uint32_t)snake.segments().size();
+    c.turnsLeft = !cursor.done();
+    return c;
+}
+
+void ReplayIndex::build(const Replay &r, const Level &level, uint64_t every)
+{
+    const ReplayHeader &h = r.header();
+    uint64_t interval = std::max<uint64_t>(1, every);
+    // No reserve from h.ticks: the header is unchecked, and a bogus count
+    // would ask for more keyframes than the game can reach. The vector grows
+    // with the keyframes the simulation actually produces.
+    frames.clear();
+
+    Snake snake(level.spawn().x, level.spawn().y, 3, (size_t)h.width * (size_t)h.height);
+    Fruit fruit(h.width, h.height, h.seed);
+    ReplayCursor cursor;
+    replayStart(r, level, snake, fruit, cursor);
+    int score = 0;
+    auto keyframe = [&](uint64_t tick)
+    {
+        frames.emplace_back();
+        ReplayKeyframe &k = frames.back();
+        k.tick = tick;
+        k.score = score;
+        k.dir = snake.getDirection();
+        const Point *a, *b;
+        size_t na, nb;
+        snake.segments().runs(a, na, b, nb);
+        k.body.assign(a, a + na);
+        k.body.insert(k.body.end(), b, b + nb);
+        k.fruit = fruit.position();
+        k.fruitSeed = fruit.seed();
+        k.rng = fruit.generator();
+        k.cursor = cursor;
+        return &k;
+    };
+    ReplayLoop loop;
+    uint64_t due = 0;
+    for (uint64_t tick = 0;; ++tick)
+    {
+        if (tick >= due)
+        {
+            keyframe(tick);
+            due = tick + interval;
+        }
+        // Stop short of the fatal tick: keyframes hold live states
+        if (tick + 1 >= h.ticks)
+            break;
+        Direction d;
+        bool turned = cursor.turnAt(tick + 1, d);
+        if (turned)
+            snake.setDirection(d);
+        StepResult s = stepRules(level, snake, fruit, score);
+        if (isDeath(s))
+            break;
+        if (!loop.step(tick + 1, snake, turned || s == StepResult::Grew))
+            continue;
+        // Periodic from here to the next turn, as in checkReplay(): one
+        // keyframe covers every lap, so memory follows the replay's content
+        // rather than the tick count it claims
+        uint64_t t = tick + 1, next = cursor.nextTurn();
+        ReplayKeyframe *k = keyframe(t);
+        k->period = loop.period();
+        if (next <= t || cursor.done())
+            break; // never turns again: k stands for every tick after it
+        k->until = std::min(next, h.ticks);
+        uint64_t skip = (k->until - 1 - t) / k->period * k->period;
+        tick = t + skip - 1;
+        due = skip ? t + skip : t + interval;
+        loop.reset();
+    }
+}
+
+void ReplayIndex::restore(const ReplayKeyframe &k, Snake &snake, Fruit &fruit)
+{
+    Point *dst = snake.restore(k.body.size(), k.dir);
+    std::copy(k.body.begin(), k.body.end(), dst);
+    fruit.restore(k.fruit, k.fruitSeed, k.rng);
+}
@@ -0,0 +1,510 @@
+// Replay archives: adaptive range coding of turns, packing and extraction
+#include "replay_archive.h"
+#include <algorithm>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+    constexpr char kMagic[8] = {'B', 'H', 'A', 'R', 'C', 'H', 'I', 'V'};
+    constexpr uint32_t kVersion = 3;
+
+    struct ArchiveHeader
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t entrySize;
+        uint64_t count;
+        uint64_t offsetsOffset; // count + 1 payload boundaries
+        uint64_t indexOffset;   // count ArchiveEntry records
+        uint8_t reserved[24];
+    };
+    static_assert(sizeof(ArchiveHeader) == 64, "ArchiveHeader is an on-disk layout");
+
+    // Binary range coder with 11-bit adaptive probabilities (the LZMA scheme)
+    constexpr int kProbBits = 11;
+    constexpr uint16_t kProbInit = 1 << (kProbBits - 1);
+    constexpr int kMoveBits = 5;
+    constexpr uint32_t kTop = 1u << 24;
+
+    class RangeEncoder
+    {
+    public:
+        explicit RangeEncoder(std::vector<uint8_t> &out) : out(out), start(out.size()) {}
+
+        void bit(uint16_t &p, int b)
+        {
+            uint32_t bound = (range >> kProbBits) * p;
+            if (!b)
+            {
+                range = bound;
+                p += ((1 << kProbBits) - p) >> kMoveBits;
+            }
+            else
+            {
+                low += bound;
+                range -= bound;
+                p -= p >> kMoveBits;
+            }
+            normalize();
+        }
+        // Equiprobable bits, no model
+        void direct(uint64_t v, int n)
+        {
+            while (n--)
+            {
+                range >>= 1;
+                if ((v >> n) & 1)
+                    low += range;
+                normalize();
+            }
+        }
+        void finish()
+        {
+            for (int i = 0; i < 5; ++i)
+                shiftLow();
+            // The first byte out is always the empty cache; the decoder skips it
+            out.erase(out.begin() + (std::ptrdiff_t)start);
+        }
+
+    private:
+        void normalize()
+        {
+            while (range < kTop)
+            {
+                range <<= 8;
+                shiftLow();
+            }
+        }
+        void shiftLow()
+        {
+            if ((uint32_t)low < 0xFF000000u || (low >> 32) != 0)
+            {
+                uint8_t carry = (uint8_t)(low >> 32);
+                uint8_t b = cache;
+                do
+                {
+                    out.push_back((uint8_t)(b + carry));
+                    b = 0xFF;
+                } while (--cacheSize != 0);
+                cache = (uint8_t)(low >> 24);
+            }
+            ++cacheSize;
+            low = (low & 0x00FFFFFFu) << 8;
+        }
+
+        std::vector<uint8_t> &out;
+        size_t start;
+        uint64_t low{0};
+        uint32_t range{0xFFFFFFFFu};
+        uint8_t cache{0};
+        uint64_t cacheSize{1};
+    };
+
+    class RangeDecoder
+    {
+    public:
+        RangeDecoder(const uint8_t *p, size_t n) : p(p), end(p + n)
+        {
+            for (int i = 0; i < 4; ++i)
+                code = (code << 8) | next();
+        }
+
+        int bit(uint16_t &prob)
+        {
+            uint32_t bound = (range >> kProbBits) * prob;
+            int b;
+            if (code < bound)
+            {
+                range = bound;
+                prob += ((1 << kProbBits) - prob) >> kMoveBits;
+                b = 0;
+            }
+            else
+            {
+                code -= bound;
+                range -= bound;
+                prob -= prob >> kMoveBits;
+                b = 1;
+            }
+            normalize();
+            return b;
+        }
+        uint64_t direct(int n)
+        {
+            uint64_t v = 0;
+            while (n--)
+            {
+                range >>= 1;
+                int b = code >= range;
+                if (b)
+                    code -= range;
+                v = (v << 1) | (uint64_t)b;
+                normalize();
+            }
+            return v;
+        }
+        // Read past the end: the encoder's output is consumed exactly
+        bool overrun() const { return past != 0; }
+
+    private:
+        uint8_t next()
+        {
+            if (p < end)
+                return *p++;
+            ++past;
+            return 0;
+        }
+        void normalize()
+        {
+            while (range < kTop)
+            {
+                range <<= 8;
+                code = (code << 8) | next();
+            }
+        }
+
+        const uint8_t *p;
+        const uint8_t *end;
+        uint32_t code{0};
+        uint32_t range{0xFFFFFFFFu};
+        int past{0};
+    };
+
+    // Directions as quarter turns clockwise from Up, so a turn is a difference
+    constexpr int kAngle[4] = {0, 2, 3, 1}; // Up, Down, Left, Right
+    constexpr Direction kFromAngle[4] = {Direction::Up, Direction::Right, Direction::Down, Direction::Left};
+
+    // Tick deltas are coded as d + 1: its bit length (modelled on the previous
+    // one), the bit under the leading one (modelled per length), then the
+    // remaining low bits raw
+    constexpr int kLenBits = 6;
+    constexpr int kLenContexts = 16;
+
+    struct Model
+    {
+        uint16_t isTurn[4];  // by the previous relative direction
+        uint16_t side[4];    // left or right, by the previous two sides
+        uint16_t reverse[1]; // reverse or straight on (not written by ReplayWriter)
+        uint16_t len[kLenContexts][1 << kLenBits];
+        uint16_t high[1 << kLenBits];
+
+        Model()
+        {
+            std::fill(&isTurn[0], &isTurn[0] + 4, kProbInit);
+            std::fill(&side[0], &side[0] + 4, kProbInit);
+            reverse[0] = kProbInit;
+            std::fill(&len[0][0], &len[0][0] + kLenContexts * (1 << kLenBits), kProbInit);
+            std::fill(&high[0], &high[0] + (1 << kLenBits), kProbInit);
+        }
+    };
+
+    struct History
+    {
+        int angle{kAngle[(int)Direction::Right]};
+        int rel{1};
+        int sides{0};
+        int lenSym{0};
+    };
+
+    int bitLength(uint64_t v)
+    {
+        return 64 - __builtin_clzll(v);
+    }
+
+    bool readVarint(const uint8_t *&p, const uint8_t *end, uint64_t &v)
+    {
+        v = 0;
+        for (int shift = 0; p < end && shift < 64; shift += 7)
+        {
+            uint8_t b = *p++;
+            v |= (uint64_t)(b & 0x7f) << shift;
+            if (!(b & 0x80))
+                return true;
+        }
+        return false;
+    }
+
+    void writeVarint(std::vector<uint8_t> &out, uint64_t v)
+    {
+        while (v >= 0x80)
+        {
+            out.push_back((uint8_t)(v | 0x80));
+            v >>= 7;
+        }
+        out.push_back((uint8_t)v);
+    }
+
+    bool writeAll(int fd, const void *data, size_t n)
+    {
+        const char *p = static_cast<const char *>(data);
+        while (n)
+        {
+            ssize_t w = ::write(fd, p, n);
+            if (w <= 0)
+                return false;
+            p += w;
+            n -= (size_t)w;
+        }
+        return true;
+    }
+}
+
+bool turn_codec::encode(const uint8_t *turns, size_t bytes, uint32_t count, std::vector<uint8_t> &out)
+{
+    Model m;
+    History h;
+    RangeEncoder rc(out);
+    const uint8_t *p = turns;
+    const uint8_t *end = turns + bytes;
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        uint64_t v;
+        if (!readVarint(p, end, v))
+            return false;
+        uint64_t delta = (v >> 2) + 1;
+        int angle = kAngle[v & 3];
+        int rel = (angle - h.angle) & 3;
+
+        int sym = bitLength(delta) - 1;
+        uint16_t *lenProbs = m.len[std::min(h.lenSym, kLenContexts - 1)];
+        for (int node = 1, b = kLenBits - 1; b >= 0; --b)
+        {
+            int bit = (sym >> b) & 1;
+            rc.bit(lenProbs[node], bit);
+            node = node * 2 + bit;
+        }
+        if (sym >= 1)
+        {
+            rc.bit(m.high[sym], (int)((delta >> (sym - 1)) & 1));
+            rc.direct(delta, sym - 1);
+        }
+
+        rc.bit(m.isTurn[h.rel], rel & 1);
+        if (rel & 1)
+        {
+            int left = rel == 3;
+            rc.bit(m.side[h.sides], left);
+            h.sides = ((h.sides << 1) | left) & 3;
+        }
+        else
+            rc.bit(m.reverse[0], rel == 2);
+
+        h.angle = angle;
+        h.rel = rel;
+        h.lenSym = sym;
+    }
+    if (p != end)
+        return false;
+    rc.finish();
+    return true;
+}
+
+bool turn_codec::decode(const uint8_t *payload, size_t bytes, uint32_t count, std::vector<uint8_t> &out)
+{
+    Model m;
+    History h;
+    RangeDecoder rc(payload, bytes);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        uint16_t *lenProbs = m.len[std::min(h.lenSym, kLenContexts - 1)];
+        int node = 1;
+        for (int b = 0; b < kLenBits; ++b)
+            node = node * 2 + rc.bit(lenProbs[node]);
+        int sym = node - (1 << kLenBits);
+        if (sym > 62)
+            return false;
+        uint64_t delta = 1;
+        if (sym >= 1)
+        {
+            delta = (delta << 1) | (uint64_t)rc.bit(m.high[sym]);
+            delta = (delta << (sym - 1)) | rc.direct(sym - 1);
+        }
+
+        int rel;
+        if (rc.bit(m.isTurn[h.rel]))
+        {
+            int left = rc.bit(m.side[h.sides]);
+            h.sides = ((h.sides << 1) | left) & 3;
+            rel = left ? 3 : 1;
+        }
+        else
+            rel = rc.bit(m.reverse[0]) ? 2 : 0;
+
+        h.angle = (h.angle + rel) & 3;
+        h.rel = rel;
+        h.lenSym = sym;
+        writeVarint(out, ((delta - 1) << 2) | (uint64_t)kFromAngle[h.angle]);
+        if (rc.overrun())
+            return false;
+    }
+    return true;
+}
+
+ReplayArchiveWriter::~ReplayArchiveWriter()
+{
+    if (fd < 0)
+        return;
+    ::close(fd);
+    unlink(tmpPath.c_str());
+}
+
+bool ReplayArchiveWriter::open(const std::string &p)
+{
+    path = p;
+    tmpPath = p + ".tmp";
+    fd = ::open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0)
+        return false;
+    ArchiveHeader h{};
+    if (!writeAll(fd, &h, sizeof h))
+        return false;
+    offset = sizeof h;
+    offsets.assign(1, offset);
+    entries.clear();
+    rawBytes = codedBytes = 0;
+    return true;
+}
+
+bool ReplayArchiveWriter::add(const Replay &r)
+{
+    if (fd < 0)
+        return false;
+    const ReplayHeader &h = r.header();
+    coded.clear();
+    if (!turn_codec::encode(r.turns(), r.turnBytes(), h.turns, coded))
+        return false;
+    // Extraction must give back the same file, so only take what round-trips
+    check.clear();
+    if (!turn_codec::decode(coded.data(), coded.size(), h.turns, check) || check.size() != r.turnBytes() ||
+        std::memcmp(check.data(), r.turns(), check.size()) != 0)
+        return false;
+    if (!writeAll(fd, coded.data(), coded.size()))
+        return false;
+
+    ArchiveEntry e{};
+    e.ticks = h.ticks;
+    e.timeSec = h.timeSec;
+    e.score = h.score;
+    e.length = h.length;
+    e.seed = h.seed;
+    e.turns = h.turns;
+    e.width = h.width;
+    e.height = h.height;
+    e.tickMs = h.tickMs;
+    e.payloadBytes = (uint32_t)coded.size();
+    std::memcpy(e.name, h.name, sizeof e.name);
+    e.level = h.level;
+    e.generator = h.generator;
+    e.name[sizeof e.name - 1] = '\0';
+    entries.push_back(e);
+    offset += coded.size();
+    offsets.push_back(offset);
+    rawBytes += r.turnBytes();
+    codedBytes += coded.size();
+    return true;
+}
+
+bool ReplayArchiveWriter::finish()
+{
+    if (fd < 0)
+        return false;
+    // Keep the tables 8-byte aligned so they can be read in place
+    static const uint8_t pad[8] = {};
+    size_t padBytes = (size_t)(-offset & 7);
+    ArchiveHeader h{};
+    std::memcpy(h.magic, kMagic, sizeof kMagic);
+    h.version = kVersion;
+    h.entrySize = sizeof(ArchiveEntry);
+    h.count = entries.size();
+    h.offsetsOffset = offset + padBytes;
+    h.indexOffset = h.offsetsOffset + offsets.size() * sizeof(uint64_t);
+
+    bool ok = writeAll(fd, pad, padBytes) &&
+              writeAll(fd, offsets.data(), offsets.size() * sizeof(uint64_t)) &&
+              writeAll(fd, entries.data(), entries.size() * sizeof(ArchiveEntry)) &&
+              pwrite(fd, &h, sizeof h, 0) == (ssize_t)sizeof h && fsync(fd) == 0;
+    ok = ::close(fd) == 0 && ok;
+    fd = -1;
+    if (ok && rename(tmpPath.c_str(), path.c_str()) == 0)
+        return true;
+    unlink(tmpPath.c_str());
+    return false;
+}
+
+bool ReplayArchive::open(const std::string &path)
+{
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return false;
+    struct stat st{};
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(ArchiveHeader))
+    {
+        ::close(fd);
+        return false;
+    }
+    size_t size = (size_t)st.st_size;
+    void *p = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED)
+        return false;
+
+    const ArchiveHeader *h = static_cast<const ArchiveHeader *>(p);
+    bool valid = std::memcmp(h->magic, kMagic, sizeof kMagic) == 0 && h->version == kVersion &&
+                 h->entrySize == sizeof(ArchiveEntry) && h->count <= size / sizeof(ArchiveEntry) &&
+                 h->offsetsOffset % 8 == 0 && h->indexOffset % 8 == 0 &&
+                 h->offsetsOffset <= size && (size - h->offsetsOffset) / 8 > h->count &&
+                 h->indexOffset <= size && (size - h->indexOffset) / sizeof(ArchiveEntry) >= h->count;
+    if (!valid)
+    {
+        munmap(p, size);
+        return false;
+    }
+    base = p;
+    mapSize = size;
+    count = (size_t)h->count;
+    offsets = reinterpret_cast<const uint64_t *>(static_cast<const char *>(p) + h->offsetsOffset);
+    entries = reinterpret_cast<const ArchiveEntry *>(static_cast<const char *>(p) + h->indexOffset);
+    return true;
+}
+
+void ReplayArchive::close()
+{
+    if (!base)
+        return;
+    munmap(base, mapSize);
+    base = nullptr;
+    mapSize = 0;
+    count = 0;
+    offsets = nullptr;
+    entries = nullptr;
+}
+
+bool ReplayArchive::extract(size_t i, std::vector<uint8_t> &file) const
+{
+    if (i >= count)
+        return false;
+    uint64_t from = offsets[i], to = offsets[i + 1];
+    if (from < sizeof(ArchiveHeader) || from > to || to > mapSize)
+        return false;
+
+    const ArchiveEntry &e = entries[i];
+    ReplayHeader h = newReplayHeader(e.width, e.height, e.tickMs, e.seed, e.level);
+    h.generator = e.generator;
+    h.ticks = e.ticks;
+    h.timeSec = e.timeSec;
+    h.score = e.score;
+    h.turns = e.turns;
+    h.length = e.length;
+    std::memcpy(h.name, e.name, sizeof h.name);
+
+    file.resize(sizeof h);
+    std::memcpy(file.data(), &h, sizeof h);
+    const uint8_t *payload = static_cast<const uint8_t *>(base) + from;
+    return turn_codec::decode(payload, (size_t)(to - from), e.turns, file);
+}
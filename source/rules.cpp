@@ -0,0 +1,27 @@
+// Game rules
+#include "rules.h"
+
+StepResult stepRules(const Level &level, Snake &snake, Fruit &fruit, int &score)
+{
+    // Next head from the level's neighbour table: a wall, or the cell
+    // beside the head, across a torus seam or out of a portal
+    Point next;
+    if (!level.step(snake.head(), snake.getDirection(), next))
+        return StepResult::HitWall;
+
+    // Self
+    if (snake.hitsSelf(next))
+        return StepResult::HitSelf;
+
+    bool grow = false;
+    if (next == fruit.position())
+    {
+        grow = true;
+        score += 10;
+        fruit.respawn([&](const Point &p)
+                      { return snake.contains(p) || p == next || level.wall(p); });
+    }
+
+    snake.move(next, grow);
+    return grow ? StepResult::Grew : StepResult::Moved;
+}
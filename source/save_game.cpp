@@ -0,0 +1,203 @@
+// Save file layout, atomic write and single-read load
+#include "save_game.h"
+#include <cstring>
+#include <type_traits>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace
+{
+    constexpr char kMagic[8] = {'B', 'H', 'S', 'A', 'V', 'E', '\0', '\0'};
+    constexpr uint32_t kVersion = 3;
+
+    static_assert(std::is_trivially_copyable<std::mt19937>::value, "generator state is saved as raw bytes");
+
+    struct Header
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t headerSize;
+        int32_t width;
+        int32_t height;
+        int32_t score;
+        int32_t tickMs;
+        uint64_t tick;
+        uint64_t length;
+        uint32_t dir;
+        uint32_t fruitSeed;
+        int32_t fruitX;
+        int32_t fruitY;
+        uint32_t seed;
+        uint16_t seeded;
+        uint16_t moved; // Direction of the last move; dir may be a turn not yet taken
+        uint32_t rngSize;   // generator bytes following the header
+        uint32_t pointSize; // body is length Points at bodyOffset
+        uint64_t bodyOffset;
+        char name[24];
+        uint64_t checksum; // header (this field zero), generator bytes and body
+        uint64_t level;
+    };
+    static_assert(sizeof(Header) == 128, "header is an on-disk layout");
+
+    uint64_t fnv(uint64_t h, const void *data, size_t n)
+    {
+        const unsigned char *p = static_cast<const unsigned char *>(data);
+        for (size_t i = 0; i < n; ++i)
+        {
+            h ^= p[i];
+            h *= 1099511628211ull;
+        }
+        return h;
+    }
+
+    uint64_t checksum(Header h, const std::mt19937 &rng, const Point *a, size_t na, const Point *b, size_t nb)
+    {
+        h.checksum = 0;
+        uint64_t sum = fnv(fnv(1469598103934665603ull, &h, sizeof h), &rng, sizeof rng);
+        return fnv(fnv(sum, a, na * sizeof(Point)), b, nb * sizeof(Point));
+    }
+
+    // A free cell of the board; anything else in a save is damage
+    bool onFloor(const Level &level, const Point &p)
+    {
+        return p.x >= 0 && p.y >= 0 && p.x < level.width() && p.y < level.height() && !level.wall(p);
+    }
+
+    bool readAt(int fd, void *buf, size_t n, off_t off)
+    {
+        char *p = static_cast<char *>(buf);
+        while (n > 0)
+        {
+            ssize_t r = pread(fd, p, n, off);
+            if (r <= 0)
+                return false;
+            p += r;
+            off += r;
+            n -= (size_t)r;
+        }
+        return true;
+    }
+
+    bool writeAll(int fd, iovec *iov, int n)
+    {
+        while (n > 0)
+        {
+            ssize_t w = writev(fd, iov, n);
+            if (w < 0)
+                return false;
+            while (n > 0 && (size_t)w >= iov->iov_len)
+            {
+                w -= (ssize_t)iov->iov_len;
+                ++iov;
+                --n;
+            }
+            if (n > 0)
+            {
+                iov->iov_base = static_cast<char *>(iov->iov_base) + w;
+                iov->iov_len -= (size_t)w;
+            }
+        }
+        return true;
+    }
+}
+
+namespace save_game
+{
+    bool write(const std::string &path, const SavedGame &g, const Snake &snake, const Fruit &fruit)
+    {
+        const SnakeBody &body = snake.segments();
+        const std::mt19937 &rng = fruit.generator();
+        Header h{};
+        std::memcpy(h.magic, kMagic, sizeof kMagic);
+        h.version = kVersion;
+        h.headerSize = sizeof h;
+        h.width = g.width;
+        h.height = g.height;
+        h.level = g.level;
+        h.score = g.score;
+        h.tickMs = g.tickMs;
+        h.tick = g.tick;
+        h.length = body.size();
+        h.dir = (uint32_t)snake.getDirection();
+        h.fruitSeed = fruit.seed();
+        h.fruitX = fruit.position().x;
+        h.fruitY = fruit.position().y;
+        h.seed = g.seed;
+        h.seeded = g.seeded;
+        h.moved = (uint16_t)snake.lastMove();
+        h.rngSize = sizeof rng;
+        h.pointSize = sizeof(Point);
+        // Body starts cache-line aligned after the generator state
+        h.bodyOffset = (sizeof h + sizeof rng + 63) & ~(uint64_t)63;
+        std::memcpy(h.name, g.name, sizeof h.name);
+        h.name[sizeof h.name - 1] = '\0';
+        static const char zeros[64] = {};
+        const Point *a, *b;
+        size_t na, nb;
+        body.runs(a, na, b, nb);
+        h.checksum = checksum(h, rng, a, na, b, nb);
+        iovec iov[5] = {
+            {&h, sizeof h},
+            {const_cast<std::mt19937 *>(&rng), sizeof rng},
+            {const_cast<char *>(zeros), (size_t)h.bodyOffset - sizeof h - sizeof rng},
+            {const_cast<Point *>(a), na * sizeof(Point)},
+            {const_cast<Point *>(b), nb * sizeof(Point)},
+        };
+
+        std::string tmp = path + ".tmp";
+        int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0)
+            return false;
+        bool ok = writeAll(fd, iov, 5) && fsync(fd) == 0;
+        ok = ::close(fd) == 0 && ok;
+        if (ok)
+            ok = std::rename(tmp.c_str(), path.c_str()) == 0;
+        if (!ok)
+            std::remove(tmp.c_str());
+        return ok;
+    }
+
+    bool read(const std::string &path, const Level &level, SavedGame &g, Snake &snake, Fruit &fruit)
+    {
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+            return false;
+        Header h{};
+        std::mt19937 rng;
+        struct stat st{};
+        uint64_t cells = (uint64_t)level.width() * (uint64_t)level.height();
+        bool ok = fstat(fd, &st) == 0 && readAt(fd, &h, sizeof h, 0) &&
+                  std::memcmp(h.magic, kMagic, sizeof kMagic) == 0 && h.version == kVersion &&
+                  h.headerSize == sizeof h && h.rngSize == sizeof rng && h.pointSize == sizeof(Point) &&
+                  h.width == level.width() && h.height == level.height() && h.level == level.id() &&
+                  h.dir <= (uint32_t)Direction::Right && h.moved <= (uint16_t)Direction::Right && h.tickMs > 0 && onFloor(level, {h.fruitX, h.fruitY}) &&
+                  h.length > 0 && h.length <= cells && h.bodyOffset >= sizeof h + sizeof rng &&
+                  (uint64_t)st.st_size == h.bodyOffset + h.length * sizeof(Point) &&
+                  readAt(fd, &rng, sizeof rng, sizeof h);
+        if (ok)
+        {
+            // The whole body in one read, straight into the ring, then
+            // checked there: the checksum, and every segment on the floor
+            Point *dst = snake.restore(h.length, (Direction)h.dir, (Direction)h.moved);
+            ok = readAt(fd, dst, h.length * sizeof(Point), (off_t)h.bodyOffset) &&
+                 h.checksum == checksum(h, rng, dst, h.length, nullptr, 0);
+            for (uint64_t i = 0; ok && i < h.length; ++i)
+                ok = onFloor(level, dst[i]);
+        }
+        ::close(fd);
+        if (!ok)
+            return false;
+
+        fruit.restore({h.fruitX, h.fruitY}, h.fruitSeed, rng);
+        g.score = h.score;
+        g.tickMs = h.tickMs;
+        g.tick = h.tick;
+        g.seed = h.seed;
+        g.seeded = h.seeded != 0;
+        std::memcpy(g.name, h.name, sizeof g.name);
+        return true;
+    }
+}
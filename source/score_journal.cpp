@@ -0,0 +1,483 @@
+// Score journal writer thread, compaction and startup summary
+#include "score_journal.h"
+#include <algorithm>
+#include <cstring>
+#include <ctime>
+#include <iomanip>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+    constexpr char kJournalMagic[8] = {'B', 'H', 'J', 'O', 'U', 'R', 'N', 'L'};
+    constexpr char kSnapshotMagic[8] = {'B', 'H', 'S', 'C', 'O', 'R', 'E', 'S'};
+    constexpr uint32_t kVersion = 1;
+
+    struct JournalHeader
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t recordSize;
+        uint64_t id; // names this journal; a snapshot records which one it absorbed
+        uint8_t reserved[40];
+    };
+    static_assert(sizeof(JournalHeader) == 64, "header is an on-disk layout");
+
+    struct SnapshotHeader
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t recordSize;
+        uint64_t games;
+        uint64_t journalId;     // journal folded into this snapshot
+        uint64_t recordsOffset; // games records, oldest first
+        uint64_t indexOffset;   // games uint32 record numbers, best score first (equal: oldest first)
+        uint32_t topCount;
+        uint32_t pad;
+        uint8_t reserved[8];
+        GameRecord top[ScoreJournal::TopK];
+    };
+    static_assert(sizeof(SnapshotHeader) == 64 + 64 * ScoreJournal::TopK, "header is an on-disk layout");
+
+    // FNV-1a over the record with its checksum field zeroed
+    uint32_t recordChecksum(const GameRecord &r)
+    {
+        GameRecord c = r;
+        c.checksum = 0;
+        const unsigned char *p = reinterpret_cast<const unsigned char *>(&c);
+        uint32_t h = 2166136261u;
+        for (size_t i = 0; i < sizeof c; ++i)
+        {
+            h ^= p[i];
+            h *= 16777619u;
+        }
+        return h;
+    }
+
+    bool readAt(int fd, void *buf, size_t n, off_t off)
+    {
+        char *p = static_cast<char *>(buf);
+        while (n > 0)
+        {
+            ssize_t r = pread(fd, p, n, off);
+            if (r <= 0)
+                return false;
+            p += r;
+            off += r;
+            n -= (size_t)r;
+        }
+        return true;
+    }
+
+    bool writeAll(int fd, const void *buf, size_t n)
+    {
+        const char *p = static_cast<const char *>(buf);
+        while (n > 0)
+        {
+            ssize_t w = write(fd, p, n);
+            if (w <= 0)
+                return false;
+            p += w;
+            n -= (size_t)w;
+        }
+        return true;
+    }
+
+    uint64_t newJournalId()
+    {
+        std::random_device rd;
+        return ((uint64_t)rd() << 32 | rd()) ^ (uint64_t)std::time(nullptr);
+    }
+
+    JournalHeader freshJournalHeader()
+    {
+        JournalHeader h{};
+        std::memcpy(h.magic, kJournalMagic, sizeof kJournalMagic);
+        h.version = kVersion;
+        h.recordSize = sizeof(GameRecord);
+        h.id = newJournalId();
+        return h;
+    }
+
+    bool loadSnapshotHeader(int fd, SnapshotHeader &h)
+    {
+        return fd >= 0 && readAt(fd, &h, sizeof h, 0) &&
+               std::memcmp(h.magic, kSnapshotMagic, sizeof kSnapshotMagic) == 0 && h.version == kVersion &&
+               h.recordSize == sizeof(GameRecord) && h.topCount <= (uint32_t)ScoreJournal::TopK;
+    }
+
+    bool loadSnapshotHeader(const std::string &path, SnapshotHeader &h)
+    {
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        bool ok = loadSnapshotHeader(fd, h);
+        if (fd >= 0)
+            ::close(fd);
+        return ok;
+    }
+
+    // Valid records of a journal, stopping at the first torn or damaged one
+    bool loadJournal(int fd, JournalHeader &h, std::vector<GameRecord> &out)
+    {
+        if (fd < 0 || !readAt(fd, &h, sizeof h, 0) ||
+            std::memcmp(h.magic, kJournalMagic, sizeof kJournalMagic) != 0 || h.version != kVersion ||
+            h.recordSize != sizeof(GameRecord))
+            return false;
+        struct stat st{};
+        if (fstat(fd, &st) != 0)
+            return false;
+        size_t n = ((size_t)st.st_size - sizeof h) / sizeof(GameRecord);
+        out.resize(n);
+        if (n && !readAt(fd, out.data(), n * sizeof(GameRecord), sizeof h))
+            n = 0;
+        size_t good = 0;
+        while (good < n && out[good].checksum == recordChecksum(out[good]))
+            ++good;
+        out.resize(good);
+        return true;
+    }
+
+    // Ranked insert into the top K; equal scores keep the earlier game first
+    void rank(ScoreJournal::Summary &s, const GameRecord &r)
+    {
+        int pos = 0;
+        while (pos < s.topCount && s.top[pos].score >= r.score)
+            ++pos;
+        if (pos >= ScoreJournal::TopK)
+            return;
+        int last = std::min(s.topCount, ScoreJournal::TopK - 1);
+        for (int i = last; i > pos; --i)
+            s.top[i] = s.top[i - 1];
+        s.top[pos] = r;
+        s.topCount = std::min(ScoreJournal::TopK, s.topCount + 1);
+    }
+
+    // Open and exclusively lock the journal, making sure the path still names
+    // the locked file (compaction swaps in a new one). An empty or foreign
+    // file gets a fresh header.
+    int lockJournal(const std::string &path)
+    {
+        for (;;)
+        {
+            int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+            if (fd < 0)
+                return -1;
+            if (flock(fd, LOCK_EX) != 0)
+            {
+                ::close(fd);
+                return -1;
+            }
+            struct stat held{}, named{};
+            if (fstat(fd, &held) != 0 || stat(path.c_str(), &named) != 0 || held.st_ino != named.st_ino ||
+                held.st_dev != named.st_dev)
+            {
+                ::close(fd);
+                continue;
+            }
+            JournalHeader h{};
+            if ((size_t)held.st_size < sizeof h || !readAt(fd, &h, sizeof h, 0) ||
+                std::memcmp(h.magic, kJournalMagic, sizeof kJournalMagic) != 0)
+            {
+                h = freshJournalHeader();
+                if (ftruncate(fd, 0) != 0 || !writeAll(fd, &h, sizeof h))
+                {
+                    ::close(fd);
+                    return -1;
+                }
+            }
+            return fd;
+        }
+    }
+
+    // Write a whole file next to path and rename it into place
+    template <typename WriteFn>
+    bool replaceFile(const std::string &path, WriteFn &&body)
+    {
+        std::string tmp = path + ".tmp";
+        int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0)
+            return false;
+        bool ok = body(fd) && fsync(fd) == 0;
+        ok = ::close(fd) == 0 && ok;
+        if (ok)
+            ok = std::rename(tmp.c_str(), path.c_str()) == 0;
+        if (!ok)
+            std::remove(tmp.c_str());
+        return ok;
+    }
+
+    void printRecord(std::ostream &out, const GameRecord &r)
+    {
+        char when[32];
+        std::time_t t = (std::time_t)r.timeSec;
+        std::tm tm{};
+        localtime_r(&t, &tm);
+        std::strftime(when, sizeof when, "%Y-%m-%d %H:%M", &tm);
+        out << std::setw(7) << r.score << "  " << std::left << std::setw(24) << r.name << std::right << "  len "
+            << std::setw(5) << r.length << "  " << std::setw(7) << r.durationMs / 1000 << "s  seed "
+            << std::setw(10) << r.seed << "  " << when << "\n";
+    }
+}
+
+bool ScoreJournal::open(const std::string &base, uint32_t compactEveryN)
+{
+    close();
+    journalPath = base + ".journal";
+    snapshotPath = base + ".snapshot";
+    compactEvery = std::max<uint32_t>(1, compactEveryN);
+    sum = Summary{};
+
+    // Constant-size startup: the snapshot header carries the totals and top K
+    SnapshotHeader snap{};
+    bool haveSnap = loadSnapshotHeader(snapshotPath, snap);
+    if (haveSnap)
+    {
+        sum.games = snap.games;
+        sum.topCount = (int)snap.topCount;
+        std::copy(snap.top, snap.top + snap.topCount, sum.top);
+    }
+    // ...plus the journal, which compaction keeps short
+    int fd = ::open(journalPath.c_str(), O_RDONLY | O_CLOEXEC);
+    JournalHeader jh{};
+    std::vector<GameRecord> recent;
+    if (loadJournal(fd, jh, recent) && !(haveSnap && snap.journalId == jh.id))
+    {
+        for (const GameRecord &r : recent)
+        {
+            ++sum.games;
+            rank(sum, r);
+        }
+    }
+    if (fd >= 0)
+        ::close(fd);
+
+    {
+        std::lock_guard<std::mutex> lk(mu);
+        queued = 0;
+        stopping = false;
+    }
+    writer = std::thread(&ScoreJournal::writerLoop, this);
+    return true;
+}
+
+void ScoreJournal::close()
+{
+    if (!writer.joinable())
+        return;
+    {
+        std::lock_guard<std::mutex> lk(mu);
+        stopping = true;
+    }
+    cv.notify_one();
+    writer.join();
+}
+
+void ScoreJournal::append(const GameRecord &r)
+{
+    ++sum.games;
+    rank(sum, r);
+    if (!writer.joinable())
+        return;
+    {
+        std::lock_guard<std::mutex> lk(mu);
+        if (queued < queueSize)
+            queue[queued++] = r;
+    }
+    cv.notify_one();
+}
+
+void ScoreJournal::writerLoop()
+{
+    // Catch up on a journal left long by an earlier run
+    uint64_t journalRecords = 0;
+    {
+        struct stat st{};
+        if (stat(journalPath.c_str(), &st) == 0 && (size_t)st.st_size > sizeof(JournalHeader))
+            journalRecords = ((size_t)st.st_size - sizeof(JournalHeader)) / sizeof(GameRecord);
+    }
+    if (journalRecords >= compactEvery && compact())
+        journalRecords = 0;
+
+    GameRecord batch[queueSize];
+    std::unique_lock<std::mutex> lk(mu);
+    while (true)
+    {
+        cv.wait(lk, [this]
+                { return stopping || queued > 0; });
+        int n = queued;
+        std::copy(queue, queue + n, batch);
+        queued = 0;
+        bool done = stopping;
+        lk.unlock();
+        if (n > 0)
+            writeBatch(batch, n, journalRecords);
+        if (journalRecords >= compactEvery && compact())
+            journalRecords = 0;
+        lk.lock();
+        if (done && queued == 0)
+            break;
+    }
+}
+
+bool ScoreJournal::writeBatch(const GameRecord *recs, int n, uint64_t &journalRecords)
+{
+    int fd = lockJournal(journalPath);
+    if (fd < 0)
+        return false;
+    GameRecord buf[queueSize];
+    for (int i = 0; i < n; ++i)
+    {
+        buf[i] = recs[i];
+        buf[i].checksum = recordChecksum(buf[i]);
+    }
+    bool ok = writeAll(fd, buf, (size_t)n * sizeof(GameRecord)) && fdatasync(fd) == 0;
+    struct stat st{};
+    if (fstat(fd, &st) == 0)
+        journalRecords = ((size_t)st.st_size - sizeof(JournalHeader)) / sizeof(GameRecord);
+    ::close(fd);
+    return ok;
+}
+
+bool ScoreJournal::compact()
+{
+    // Holding the journal lock keeps other instances' appends out until the
+    // new snapshot and an empty journal are both in place
+    int jfd = lockJournal(journalPath);
+    if (jfd < 0)
+        return false;
+    JournalHeader jh{};
+    std::vector<GameRecord> fresh;
+    loadJournal(jfd, jh, fresh);
+
+    SnapshotHeader old{};
+    int sfd = ::open(snapshotPath.c_str(), O_RDONLY | O_CLOEXEC);
+    bool haveOld = loadSnapshotHeader(sfd, old);
+    bool ok = true;
+    // Same id: an earlier compaction wrote the snapshot but died before
+    // resetting the journal, so its records are already folded in
+    if (!(haveOld && old.journalId == jh.id))
+    {
+        std::vector<GameRecord> all;
+        std::vector<uint32_t> oldIndex;
+        if (haveOld)
+        {
+            all.resize(old.games);
+            oldIndex.resize(old.games);
+            ok = old.games == 0 ||
+                 (readAt(sfd, all.data(), all.size() * sizeof(GameRecord), (off_t)old.recordsOffset) &&
+                  readAt(sfd, oldIndex.data(), oldIndex.size() * sizeof(uint32_t), (off_t)old.indexOffset));
+            for (uint32_t i : oldIndex)
+                ok = ok && i < old.games;
+        }
+        if (ok)
+        {
+            // The old index is already in order: sort only the new games and
+            // merge, old ones first on equal scores since they're earlier
+            uint32_t base = (uint32_t)all.size();
+            all.insert(all.end(), fresh.begin(), fresh.end());
+            std::vector<uint32_t> added(fresh.size());
+            std::iota(added.begin(), added.end(), base);
+            auto better = [&](uint32_t a, uint32_t b)
+            { return all[a].score > all[b].score; };
+            std::stable_sort(added.begin(), added.end(), better);
+            std::vector<uint32_t> index(all.size());
+            std::merge(oldIndex.begin(), oldIndex.end(), added.begin(), added.end(), index.begin(), better);
+
+            SnapshotHeader h{};
+            std::memcpy(h.magic, kSnapshotMagic, sizeof kSnapshotMagic);
+            h.version = kVersion;
+            h.recordSize = sizeof(GameRecord);
+            h.games = all.size();
+            h.journalId = jh.id;
+            h.recordsOffset = sizeof h;
+            h.indexOffset = h.recordsOffset + all.size() * sizeof(GameRecord);
+            h.topCount = (uint32_t)std::min<size_t>(TopK, all.size());
+            for (uint32_t i = 0; i < h.topCount; ++i)
+                h.top[i] = all[index[i]];
+            ok = replaceFile(snapshotPath, [&](int fd)
+                             { return writeAll(fd, &h, sizeof h) &&
+                                      writeAll(fd, all.data(), all.size() * sizeof(GameRecord)) &&
+                                      writeAll(fd, index.data(), index.size() * sizeof(uint32_t)); });
+        }
+    }
+    if (sfd >= 0)
+        ::close(sfd);
+    if (ok)
+    {
+        JournalHeader empty = freshJournalHeader();
+        ok = replaceFile(journalPath, [&](int fd)
+                         { return writeAll(fd, &empty, sizeof empty); });
+    }
+    ::close(jfd);
+    return ok;
+}
+
+bool ScoreJournal::dump(const std::string &base, std::ostream &out, size_t top, size_t recent)
+{
+    SnapshotHeader snap{};
+    int sfd = ::open((base + ".snapshot").c_str(), O_RDONLY | O_CLOEXEC);
+    bool haveSnap = loadSnapshotHeader(sfd, snap);
+    int jfd = ::open((base + ".journal").c_str(), O_RDONLY | O_CLOEXEC);
+    JournalHeader jh{};
+    std::vector<GameRecord> journal;
+    bool haveJournal = loadJournal(jfd, jh, journal);
+    if (jfd >= 0)
+        ::close(jfd);
+    if (!haveSnap && !haveJournal)
+    {
+        if (sfd >= 0)
+            ::close(sfd);
+        return false;
+    }
+    if (haveSnap && haveJournal && snap.journalId == jh.id)
+        journal.clear();
+
+    // The best `top` compacted games through the index, then the journal's:
+    // a game in the overall top is in one of the two. Stable, so equal
+    // scores keep the earlier game first.
+    uint64_t compacted = haveSnap ? snap.games : 0;
+    std::vector<GameRecord> best;
+    for (uint64_t i = 0; i < compacted && i < top; ++i)
+    {
+        uint32_t n = 0;
+        GameRecord r{};
+        if (!readAt(sfd, &n, sizeof n, (off_t)(snap.indexOffset + i * sizeof n)) || n >= compacted ||
+            !readAt(sfd, &r, sizeof r, (off_t)(snap.recordsOffset + n * sizeof r)))
+            break;
+        best.push_back(r);
+    }
+    best.insert(best.end(), journal.begin(), journal.end());
+    std::stable_sort(best.begin(), best.end(), [](const GameRecord &a, const GameRecord &b)
+                     { return a.score > b.score; });
+    best.resize(std::min(best.size(), top));
+
+    out << "games: " << compacted + journal.size() << " (" << compacted << " compacted, " << journal.size()
+        << " in journal)\n\ntop scores:\n";
+    for (size_t i = 0; i < best.size(); ++i)
+    {
+        out << std::setw(3) << i + 1 << " ";
+        printRecord(out, best[i]);
+    }
+
+    // Most recent first: journal tail, then the end of the snapshot's
+    // record array, read by offset rather than scanning the history
+    out << "\nrecent games:\n";
+    size_t shown = 0;
+    for (size_t i = journal.size(); i-- > 0 && shown < recent; ++shown)
+        printRecord(out, journal[i]);
+    for (uint64_t i = haveSnap ? snap.games : 0; i-- > 0 && shown < recent; ++shown)
+    {
+        GameRecord r{};
+        if (!readAt(sfd, &r, sizeof r, (off_t)(snap.recordsOffset + i * sizeof r)))
+            break;
+        printRecord(out, r);
+    }
+    if (sfd >= 0)
+        ::close(sfd);
+    return true;
+}
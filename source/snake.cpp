@@ -1,10 +1,35 @@
 // Snake implementation
 #include "snake.h"
-#include <algorithm>
+#include "trace.h"
 
-Snake::Snake(int startX, int startY, int initialLength)
-    : dir(Direction::Right)
+void SnakeBody::reserve(size_t n)
 {
+    if (n <= buf.size())
+        return;
+    size_t cap = 4;
+    while (cap < n)
+        cap <<= 1;
+    // Unwrap into the new buffer so the head lands at index 0
+    std::vector<Point> next(cap);
+    for (size_t i = 0; i < count; ++i)
+        next[i] = (*this)[i];
+    buf.swap(next);
+    mask = cap - 1;
+    first = 0;
+}
+
+Snake::Snake(int startX, int startY, int initialLength, size_t capacity)
+    : dir(Direction::Right), moved(Direction::Right)
+{
+    body.reserve(capacity > (size_t)initialLength ? capacity : (size_t)initialLength);
+    reset(startX, startY, initialLength);
+}
+
+void Snake::reset(int startX, int startY, int initialLength)
+{
+    dir = Direction::Right;
+    moved = Direction::Right;
+    body.clear();
     // Head at start, extend to the left
     for (int i = 0; i < initialLength; ++i)
     {
@@ -14,54 +39,37 @@ Snake::Snake(int startX, int startY, int initialLength)
 
 void Snake::setDirection(Direction d)
 {
-    // prevent reversing direction directly
-    if ((dir == Direction::Up && d == Direction::Down) ||
-        (dir == Direction::Down && d == Direction::Up) ||
-        (dir == Direction::Left && d == Direction::Right) ||
-        (dir == Direction::Right && d == Direction::Left))
+    // prevent reversing into the neck
+    if ((moved == Direction::Up && d == Direction::Down) ||
+        (moved == Direction::Down && d == Direction::Up) ||
+        (moved == Direction::Left && d == Direction::Right) ||
+        (moved == Direction::Right && d == Direction::Left))
     {
         return;
     }
     dir = d;
 }
 
-Point Snake::nextHead() const
-{
-    Point h = body.front();
-    switch (dir)
-    {
-    case Direction::Up:
-        --h.y;
-        break;
-    case Direction::Down:
-        ++h.y;
-        break;
-    case Direction::Left:
-        --h.x;
-        break;
-    case Direction::Right:
-        ++h.x;
-        break;
-    }
-    return h;
-}
-
 bool Snake::hitsSelf(const Point &next) const
 {
-    return std::any_of(body.begin(), body.end(), [&](const Point &p)
-                       { return p == next; });
+    return contains(next);
 }
 
 bool Snake::contains(const Point &p) const
 {
-    return std::any_of(body.begin(), body.end(), [&](const Point &s)
-                       { return s == p; });
+    for (size_t i = 0, n = body.size(); i < n; ++i)
+    {
+        if (body[i] == p)
+            return true;
+    }
+    return false;
 }
 
-void Snake::move(bool grow)
+void Snake::move(const Point &newHead, bool grow)
 {
-    Point newHead = nextHead();
+    TraceSpan span("Snake::move");
     body.push_front(newHead);
+    moved = dir;
     if (!grow)
     {
         body.pop_back();
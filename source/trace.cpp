@@ -0,0 +1,164 @@
+// Chrome trace-event writer
+#include "trace.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+namespace
+{
+    struct Event
+    {
+        const char *name;
+        uint64_t start;
+        uint64_t dur;
+        uint32_t tid;
+    };
+    using Batch = std::vector<Event>;
+    constexpr size_t batchSize = 1024;
+
+    std::atomic<bool> g_enabled{false};
+    std::atomic<uint32_t> g_nextTid{1};
+    std::mutex g_mu;
+    std::condition_variable g_cv;
+    std::vector<Batch> g_pending;
+    // Batches touched by every thread, so stop() can flush partial ones
+    std::vector<Batch *> g_threadBatches;
+    bool g_stopping = false;
+    std::thread g_writer;
+    FILE *g_out = nullptr;
+    uint64_t g_origin = 0;
+    bool g_first = true;
+
+    struct ThreadBatch
+    {
+        Batch events;
+        uint32_t tid;
+        ThreadBatch() : tid(g_nextTid.fetch_add(1, std::memory_order_relaxed))
+        {
+            events.reserve(batchSize);
+            std::lock_guard<std::mutex> lk(g_mu);
+            g_threadBatches.push_back(&events);
+        }
+        ~ThreadBatch()
+        {
+            std::lock_guard<std::mutex> lk(g_mu);
+            if (!events.empty())
+                g_pending.push_back(std::move(events));
+            for (auto &b : g_threadBatches)
+                if (b == &events)
+                    b = nullptr;
+            g_cv.notify_one();
+        }
+    };
+
+    ThreadBatch &threadBatch()
+    {
+        thread_local ThreadBatch tb;
+        return tb;
+    }
+
+    void writeBatch(const Batch &b)
+    {
+        for (const Event &e : b)
+        {
+            // Timestamps are microseconds relative to start()
+            std::fprintf(g_out, "%s\n{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%d,\"tid\":%u}",
+                         g_first ? "" : ",", e.name,
+                         (double)(e.start - g_origin) / 1000.0, (double)e.dur / 1000.0,
+                         (int)getpid(), e.tid);
+            g_first = false;
+        }
+    }
+
+    void writerLoop()
+    {
+        std::unique_lock<std::mutex> lk(g_mu);
+        while (true)
+        {
+            g_cv.wait(lk, []
+                      { return g_stopping || !g_pending.empty(); });
+            std::vector<Batch> work;
+            work.swap(g_pending);
+            bool done = g_stopping;
+            lk.unlock();
+            for (const Batch &b : work)
+                writeBatch(b);
+            lk.lock();
+            if (done && g_pending.empty())
+                break;
+        }
+    }
+}
+
+namespace trace
+{
+    bool start(const std::string &path)
+    {
+        if (g_enabled.load())
+            return true;
+        g_out = std::fopen(path.c_str(), "w");
+        if (!g_out)
+            return false;
+        // Large stdio buffer: the writer thread does few, big writes
+        std::setvbuf(g_out, nullptr, _IOFBF, 1 << 20);
+        std::fputs("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", g_out);
+        g_origin = nowNs();
+        g_first = true;
+        g_stopping = false;
+        g_writer = std::thread(writerLoop);
+        g_enabled.store(true, std::memory_order_release);
+        return true;
+    }
+
+    void stop()
+    {
+        if (!g_enabled.exchange(false))
+            return;
+        {
+            std::lock_guard<std::mutex> lk(g_mu);
+            for (Batch *b : g_threadBatches)
+            {
+                if (b && !b->empty())
+                {
+                    g_pending.push_back(std::move(*b));
+                    b->clear();
+                }
+            }
+            g_stopping = true;
+        }
+        g_cv.notify_one();
+        g_writer.join();
+        std::fputs("\n]}\n", g_out);
+        std::fclose(g_out);
+        g_out = nullptr;
+    }
+
+    bool enabled()
+    {
+        return g_enabled.load(std::memory_order_relaxed);
+    }
+
+    void complete(const char *name, uint64_t startNs, uint64_t endNs)
+    {
+        if (!enabled())
+            return;
+        ThreadBatch &tb = threadBatch();
+        tb.events.push_back({name, startNs, endNs - startNs, tb.tid});
+        if (tb.events.size() >= batchSize)
+        {
+            Batch full;
+            full.reserve(batchSize);
+            full.swap(tb.events);
+            {
+                std::lock_guard<std::mutex> lk(g_mu);
+                g_pending.push_back(std::move(full));
+            }
+            g_cv.notify_one();
+        }
+    }
+}
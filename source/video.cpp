@@ -0,0 +1,228 @@
+// Frame rasterizer: board, snake and fruit into RGB, then Y4M or PPM
+#include "video.h"
+#include "palette.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+namespace
+{
+    constexpr palette::Rgb kBackground{14, 14, 18};
+    constexpr palette::Rgb kEye{20, 20, 24};
+
+    // BT.601 limited range, 8-bit fixed point
+    inline uint8_t lumaOf(int r, int g, int b) { return (uint8_t)(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16); }
+    inline uint8_t cbOf(int r, int g, int b) { return (uint8_t)(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128); }
+    inline uint8_t crOf(int r, int g, int b) { return (uint8_t)(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128); }
+}
+
+FrameRasterizer::FrameRasterizer(const Level &level, int cellPx)
+    : width(level.width()), height(level.height()), cell(std::max(1, cellPx)), pw(width * cell), ph(height * cell),
+      background((size_t)pw * (size_t)ph * 3)
+{
+    uint8_t *bg = background.data();
+    fillRect(bg, 0, 0, pw, ph, kBackground.r, kBackground.g, kBackground.b);
+
+    // Walls: the same gradients as the terminal border. A torus seam is
+    // dashed: every other border cell, inset.
+    bool torus = level.topology() == Topology::Torus;
+    int inset = cell / 4;
+    auto borderCell = [&](int x, int y, const palette::Rgb &c)
+    {
+        if (!torus)
+            fillRect(bg, x * cell, y * cell, (x + 1) * cell, (y + 1) * cell, c.r, c.g, c.b);
+        else if (((x + y) & 1) == 0)
+            fillRect(bg, x * cell + inset, y * cell + inset, (x + 1) * cell - inset, (y + 1) * cell - inset, c.r,
+                     c.g, c.b);
+    };
+    for (int x = 0; x < width; ++x)
+    {
+        palette::Rgb c = palette::border((float)x / (float)(width - 1));
+        borderCell(x, 0, c);
+        borderCell(x, height - 1, c);
+    }
+    for (int y = 1; y < height - 1; ++y)
+    {
+        float t = (float)y / (float)(height - 1);
+        borderCell(0, y, palette::border(t));
+        borderCell(width - 1, y, palette::border(1.0f - t));
+    }
+
+    // Inner walls take the gradient across the board; a dot in the middle
+    // of every free cell
+    int dot = std::max(1, cell / 4);
+    int off = (cell - dot) / 2;
+    for (int y = 1; y < height - 1; ++y)
+        for (int x = 1; x < width - 1; ++x)
+        {
+            if (level.wall({x, y}))
+            {
+                palette::Rgb c = palette::border((float)x / (float)(width - 1));
+                fillRect(bg, x * cell, y * cell, (x + 1) * cell, (y + 1) * cell, c.r, c.g, c.b);
+                continue;
+            }
+            palette::Rgb c = palette::grid(((x + y) & 1) == 1);
+            fillRect(bg, x * cell + off, y * cell + off, x * cell + off + dot, y * cell + off + dot, c.r, c.g, c.b);
+        }
+
+    // Portal ends: rings in the pair's colour
+    int ring = std::max(1, inset);
+    for (size_t i = 0; i < level.portals().size(); ++i)
+    {
+        const LevelPortal &p = level.portals()[i];
+        palette::Rgb c = palette::portal(i);
+        for (const Point &e : {Point{p.ax, p.ay}, Point{p.bx, p.by}})
+        {
+            fillRect(bg, e.x * cell, e.y * cell, (e.x + 1) * cell, (e.y + 1) * cell, c.r, c.g, c.b);
+            fillRect(bg, e.x * cell + ring, e.y * cell + ring, (e.x + 1) * cell - ring, (e.y + 1) * cell - ring,
+                     kBackground.r, kBackground.g, kBackground.b);
+        }
+    }
+}
+
+void FrameRasterizer::fillRect(uint8_t *rgb, int x0, int y0, int x1, int y1, uint8_t r, uint8_t g, uint8_t b) const
+{
+    x0 = std::max(x0, 0);
+    y0 = std::max(y0, 0);
+    x1 = std::min(x1, pw);
+    y1 = std::min(y1, ph);
+    for (int y = y0; y < y1; ++y)
+    {
+        uint8_t *p = rgb + ((size_t)y * (size_t)pw + (size_t)x0) * 3;
+        for (int x = x0; x < x1; ++x, p += 3)
+        {
+            p[0] = r;
+            p[1] = g;
+            p[2] = b;
+        }
+    }
+}
+
+void FrameRasterizer::draw(const VideoFrame &f, uint8_t *rgb) const
+{
+    std::memcpy(rgb, background.data(), background.size());
+
+    // Fruit: a disc
+    {
+        palette::Rgb c = palette::fruit;
+        float rad = (float)cell * 0.42f, mid = (float)cell * 0.5f - 0.5f;
+        int x0 = f.fruit.x * cell, y0 = f.fruit.y * cell;
+        for (int y = 0; y < cell; ++y)
+            for (int x = 0; x < cell; ++x)
+            {
+                float dx = (float)x - mid, dy = (float)y - mid;
+                if (dx * dx + dy * dy <= rad * rad)
+                    fillRect(rgb, x0 + x, y0 + y, x0 + x + 1, y0 + y + 1, c.r, c.g, c.b);
+            }
+    }
+
+    // Snake: inset squares, each joined to the segment before it
+    int n = (int)f.body.size();
+    int m = cell >= 6 ? 1 : 0;
+    for (int i = n - 1; i >= 0; --i)
+    {
+        const Point &p = f.body[(size_t)i];
+        palette::Rgb c = palette::snake((float)i / (float)std::max(1, n - 1));
+        int x0 = p.x * cell, y0 = p.y * cell;
+        fillRect(rgb, x0 + m, y0 + m, x0 + cell - m, y0 + cell - m, c.r, c.g, c.b);
+        if (i > 0 && m)
+        {
+            const Point &q = f.body[(size_t)i - 1];
+            if (q.x == p.x - 1 && q.y == p.y)
+                fillRect(rgb, x0 - m, y0 + m, x0 + m, y0 + cell - m, c.r, c.g, c.b);
+            else if (q.x == p.x + 1 && q.y == p.y)
+                fillRect(rgb, x0 + cell - m, y0 + m, x0 + cell + m, y0 + cell - m, c.r, c.g, c.b);
+            else if (q.y == p.y - 1 && q.x == p.x)
+                fillRect(rgb, x0 + m, y0 - m, x0 + cell - m, y0 + m, c.r, c.g, c.b);
+            else if (q.y == p.y + 1 && q.x == p.x)
+                fillRect(rgb, x0 + m, y0 + cell - m, x0 + cell - m, y0 + cell + m, c.r, c.g, c.b);
+        }
+    }
+
+    // Eyes on the head, looking the way it moves
+    if (n > 0 && cell >= 6)
+    {
+        const Point &h = f.body[0];
+        int fx = 0, fy = 0;
+        switch (f.dir)
+        {
+        case Direction::Up:
+            fy = -1;
+            break;
+        case Direction::Down:
+            fy = 1;
+            break;
+        case Direction::Left:
+            fx = -1;
+            break;
+        case Direction::Right:
+            fx = 1;
+            break;
+        }
+        int e = std::max(1, cell / 6);
+        int cx = h.x * cell + cell / 2, cy = h.y * cell + cell / 2;
+        int ahead = cell / 5, side = cell / 4;
+        for (int s = -1; s <= 1; s += 2)
+        {
+            int ex = cx + fx * ahead + fy * side * s - e / 2;
+            int ey = cy + fy * ahead + fx * side * s - e / 2;
+            fillRect(rgb, ex, ey, ex + e, ey + e, kEye.r, kEye.g, kEye.b);
+        }
+    }
+}
+
+std::string FrameRasterizer::y4mHeader(int fpsNum, int fpsDen) const
+{
+    char h[96];
+    std::snprintf(h, sizeof h, "YUV4MPEG2 W%d H%d F%d:%d Ip A1:1 C420jpeg\n", pw, ph, fpsNum, fpsDen);
+    return h;
+}
+
+void FrameRasterizer::encode(const VideoFrame &f, VideoFormat format, std::vector<uint8_t> &rgb,
+                             std::vector<uint8_t> &out) const
+{
+    rgb.resize(background.size());
+    draw(f, rgb.data());
+
+    if (format == VideoFormat::PPM)
+    {
+        char h[48];
+        int n = std::snprintf(h, sizeof h, "P6\n%d %d\n255\n", pw, ph);
+        out.resize((size_t)n + rgb.size());
+        std::memcpy(out.data(), h, (size_t)n);
+        std::memcpy(out.data() + n, rgb.data(), rgb.size());
+        return;
+    }
+
+    // 4:2:0: full-resolution luma, chroma from each 2x2 block's mean colour
+    static const char kFrame[] = "FRAME\n";
+    size_t hdr = sizeof kFrame - 1;
+    int cw = (pw + 1) / 2, ch = (ph + 1) / 2;
+    size_t lumaSize = (size_t)pw * (size_t)ph, chromaSize = (size_t)cw * (size_t)ch;
+    out.resize(hdr + lumaSize + 2 * chromaSize);
+    std::memcpy(out.data(), kFrame, hdr);
+    uint8_t *yp = out.data() + hdr;
+    uint8_t *up = yp + lumaSize;
+    uint8_t *vp = up + chromaSize;
+
+    const uint8_t *src = rgb.data();
+    for (size_t i = 0; i < lumaSize; ++i, src += 3)
+        yp[i] = lumaOf(src[0], src[1], src[2]);
+    for (int cy = 0; cy < ch; ++cy)
+    {
+        int y0 = cy * 2, y1 = std::min(y0 + 1, ph - 1);
+        for (int cx = 0; cx < cw; ++cx)
+        {
+            int x0 = cx * 2, x1 = std::min(x0 + 1, pw - 1);
+            const uint8_t *a = rgb.data() + ((size_t)y0 * (size_t)pw + (size_t)x0) * 3;
+            const uint8_t *b = rgb.data() + ((size_t)y0 * (size_t)pw + (size_t)x1) * 3;
+            const uint8_t *c = rgb.data() + ((size_t)y1 * (size_t)pw + (size_t)x0) * 3;
+            const uint8_t *d = rgb.data() + ((size_t)y1 * (size_t)pw + (size_t)x1) * 3;
+            int r = (a[0] + b[0] + c[0] + d[0] + 2) >> 2;
+            int g = (a[1] + b[1] + c[1] + d[1] + 2) >> 2;
+            int bl = (a[2] + b[2] + c[2] + d[2] + 2) >> 2;
+            up[(size_t)cy * (size_t)cw + (size_t)cx] = cbOf(r, g, bl);
+            vp[(size_t)cy * (size_t)cw + (size_t)cx] = crOf(r, g, bl);
+        }
+    }
+}
@@ -0,0 +1,252 @@
+// Level tool: build level files from text, as plain boxes or generated,
+// show and check them
+#include "level.h"
+#include "level_gen.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+    void usage(const char *argv0)
+    {
+        std::fprintf(stderr,
+                     "usage: %s pack TEXT OUT.bhl [--name NAME] [--torus]\n"
+                     "       %s box WxH OUT.bhl [--name NAME] [--torus]\n"
+                     "       %s gen maze|rooms|blocks WxH SEED OUT.bhl [--name NAME] [--torus]\n"
+                     "       %s info LEVEL\n"
+                     "       %s show LEVEL\n"
+                     "  TEXT: one line per row, '#' wall, '@' spawn (default: the middle),\n"
+                     "        a-z portal ends (each letter twice), anything else free;\n"
+                     "        the border must be wall\n"
+                     "  --torus  heads crossing the border come back in on the other side\n",
+                     argv0, argv0, argv0, argv0, argv0);
+    }
+
+    // Trailing --name NAME, if any
+    const char *nameArg(int argc, char **argv, int from)
+    {
+        for (int i = from; i + 1 < argc; ++i)
+            if (std::strcmp(argv[i], "--name") == 0)
+                return argv[i + 1];
+        return "";
+    }
+
+    // Trailing --torus, if any
+    Topology topologyArg(int argc, char **argv, int from)
+    {
+        for (int i = from; i < argc; ++i)
+            if (std::strcmp(argv[i], "--torus") == 0 && std::strcmp(argv[i - 1], "--name") != 0)
+                return Topology::Torus;
+        return Topology::Walled;
+    }
+
+    int save(const char *out, int width, int height, const Point &spawn, const std::vector<uint64_t> &mask,
+             const char *name, Topology topology, const std::vector<LevelPortal> &portals = {})
+    {
+        if (const char *why = level_file::check(width, height, spawn, mask.data(), portals.data(), portals.size()))
+        {
+            std::fprintf(stderr, "not a playable level: %s\n", why);
+            return 1;
+        }
+        if (!level_file::write(out, width, height, spawn, mask.data(), name, topology, portals.data(),
+                               portals.size()))
+        {
+            std::fprintf(stderr, "cannot write %s\n", out);
+            return 1;
+        }
+        std::printf("%s: %dx%d%s, %zu portals, id %016llx\n", out, width, height,
+                    topology == Topology::Torus ? " torus" : "", portals.size(),
+                    (unsigned long long)level_file::idOf(width, height, spawn, mask.data(), topology,
+                                                         portals.data(), portals.size()));
+        return 0;
+    }
+
+    int pack(int argc, char **argv)
+    {
+        if (argc < 4)
+        {
+            usage(argv[0]);
+            return 2;
+        }
+        std::ifstream in(argv[2]);
+        if (!in)
+        {
+            std::fprintf(stderr, "cannot read %s\n", argv[2]);
+            return 1;
+        }
+        std::vector<std::string> rows;
+        std::string line;
+        size_t width = 0;
+        while (std::getline(in, line))
+        {
+            if (!line.empty() && line.back() == '\r')
+                line.pop_back();
+            width = std::max(width, line.size());
+            rows.push_back(line);
+        }
+        int w = (int)width, h = (int)rows.size();
+        if (w < 5 || h < 3)
+        {
+            std::fprintf(stderr, "not a playable level: board must be 5x3 to 65535x65535\n");
+            return 1;
+        }
+        std::vector<uint64_t> mask(level_file::maskWords(w, h), 0);
+        Point spawn{w / 2, h / 2};
+        // Portal ends by letter, in the order they are first seen
+        std::vector<std::vector<Point>> ends(26);
+        std::string order;
+        for (int y = 0; y < h; ++y)
+            for (int x = 0; x < (int)rows[(size_t)y].size(); ++x)
+            {
+                char c = rows[(size_t)y][(size_t)x];
+                if (c == '#')
+                    level_file::setWall(mask.data(), w, {x, y});
+                else if (c == '@')
+                    spawn = {x, y};
+                else if (c >= 'a' && c <= 'z')
+                {
+                    level_file::setWall(mask.data(), w, {x, y});
+                    if (ends[(size_t)(c - 'a')].empty())
+                        order += c;
+                    ends[(size_t)(c - 'a')].push_back({x, y});
+                }
+            }
+        std::vector<LevelPortal> portals;
+        for (char c : order)
+        {
+            const std::vector<Point> &e = ends[(size_t)(c - 'a')];
+            if (e.size() != 2)
+            {
+                std::fprintf(stderr, "not a playable level: portal '%c' needs two ends, not %zu\n", c, e.size());
+                return 1;
+            }
+            portals.push_back({e[0].x, e[0].y, e[1].x, e[1].y});
+        }
+        return save(argv[3], w, h, spawn, mask, nameArg(argc, argv, 4), topologyArg(argc, argv, 4), portals);
+    }
+
+    int box(int argc, char **argv)
+    {
+        int w = 0, h = 0;
+        if (argc < 4 || std::sscanf(argv[2], "%dx%d", &w, &h) != 2 || w < 5 || h < 3 || w > 65535 || h > 65535)
+        {
+            usage(argv[0]);
+            return 2;
+        }
+        Level plain = Level::rectangle(w, h);
+        std::vector<uint64_t> mask(plain.mask(), plain.mask() + level_file::maskWords(w, h));
+        return save(argv[3], w, h, plain.spawn(), mask, nameArg(argc, argv, 4), topologyArg(argc, argv, 4));
+    }
+
+    int gen(int argc, char **argv)
+    {
+        LevelStyle style{};
+        int w = 0, h = 0;
+        if (argc < 6 || !parseLevelStyle(argv[2], style) || std::sscanf(argv[3], "%dx%d", &w, &h) != 2 || w < 5 ||
+            h < 3 || w > 65535 || h > 65535)
+        {
+            usage(argv[0]);
+            return 2;
+        }
+        LevelGenerator generator;
+        Level l;
+        auto t0 = std::chrono::steady_clock::now();
+        generator.generate(style, w, h, std::strtoull(argv[4], nullptr, 0), l);
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+        // Checked again by a separate fill, as the game never does
+        size_t free = LevelGenerator::freeCells(l), reached = generator.reachable(l);
+        std::printf("%s: %zu free cells, %zu reachable from the spawn, generated in %.2f ms\n",
+                    levelStyleName(style), free, reached, ms);
+        if (reached != free)
+            return 1;
+        std::vector<uint64_t> mask(l.mask(), l.mask() + level_file::maskWords(w, h));
+        return save(argv[5], w, h, l.spawn(), mask, nameArg(argc, argv, 6), topologyArg(argc, argv, 6));
+    }
+
+    int info(int argc, char **argv)
+    {
+        if (argc < 3)
+        {
+            usage(argv[0]);
+            return 2;
+        }
+        auto t0 = std::chrono::steady_clock::now();
+        Level l;
+        bool ok = l.open(argv[2]);
+        double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count();
+        if (!ok)
+        {
+            std::fprintf(stderr, "not a level file: %s\n", argv[2]);
+            return 1;
+        }
+        // The one full pass over the mask; the game itself never makes one
+        size_t words = level_file::maskWords(l.width(), l.height());
+        uint64_t walls = 0;
+        for (size_t i = 0; i < words; ++i)
+            walls += (uint64_t)__builtin_popcountll(l.mask()[i]);
+        bool intact = level_file::idOf(l.width(), l.height(), l.spawn(), l.mask(), l.topology(), l.portals().data(),
+                                       l.portals().size()) == l.id();
+        uint64_t cells = (uint64_t)l.width() * (uint64_t)l.height();
+        std::printf("name   %s\n"
+                    "board  %dx%d (%llu cells, %llu walls, %.1f%%)\n"
+                    "edges  %s, %zu portals\n"
+                    "spawn  %d,%d\n"
+                    "id     %016llx (%s)\n"
+                    "opened in %.0f us (neighbour table %s)\n",
+                    l.name()[0] ? l.name() : "-", l.width(), l.height(), (unsigned long long)cells,
+                    (unsigned long long)walls, 100.0 * (double)walls / (double)cells,
+                    l.topology() == Topology::Torus ? "torus" : "walled", l.portals().size(), l.spawn().x,
+                    l.spawn().y, (unsigned long long)l.id(), intact ? "matches the board" : "DOES NOT match the board",
+                    us, cells <= Level::kLinkedCells ? "built" : "skipped, too large");
+        return intact ? 0 : 1;
+    }
+
+    int show(int argc, char **argv)
+    {
+        Level l;
+        if (argc < 3 || !l.open(argv[2]))
+        {
+            std::fprintf(stderr, "not a level file: %s\n", argc < 3 ? "" : argv[2]);
+            return 1;
+        }
+        std::string row((size_t)l.width(), ' ');
+        for (int y = 0; y < l.height(); ++y)
+        {
+            for (int x = 0; x < l.width(); ++x)
+                row[(size_t)x] = l.wall({x, y}) ? '#' : l.spawn() == Point{x, y} ? '@' : ' ';
+            // Portal ends as pack reads them; past 26 pairs the letters repeat
+            for (size_t i = 0; i < l.portals().size(); ++i)
+            {
+                const LevelPortal &p = l.portals()[i];
+                if (p.ay == y)
+                    row[(size_t)p.ax] = (char)('a' + i % 26);
+                if (p.by == y)
+                    row[(size_t)p.bx] = (char)('a' + i % 26);
+            }
+            std::printf("%s\n", row.c_str());
+        }
+        return 0;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    std::string cmd = argc > 1 ? argv[1] : "";
+    if (cmd == "pack")
+        return pack(argc, argv);
+    if (cmd == "box")
+        return box(argc, argv);
+    if (cmd == "gen")
+        return gen(argc, argv);
+    if (cmd == "info")
+        return info(argc, argv);
+    if (cmd == "show")
+        return show(argc, argv);
+    usage(argv[0]);
+    return 2;
+}
@@ -0,0 +1,274 @@
+// Replay archive tool: pack .bhr files into one archive, list and query its
+// index, and extract single replays back out
+#include "replay_archive.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <vector>
+
+#include <dirent.h>
+#include <sys/stat.h>
+
+namespace
+{
+    void usage(const char *argv0)
+    {
+        std::fprintf(stderr,
+                     "usage: %s pack OUT.bha FILE|DIR...\n"
+                     "       %s list ARCHIVE\n"
+                     "       %s query ARCHIVE [--board WxH] [--player NAME] [--seed N] [--since YYYY-MM-DD]\n"
+                     "                 [--by score|length|ticks|date] [--top N]\n"
+                     "       %s extract ARCHIVE N OUT.bhr\n",
+                     argv0, argv0, argv0, argv0);
+    }
+
+    bool hasSuffix(const std::string &s, const char *suffix)
+    {
+        size_t n = std::strlen(suffix);
+        return s.size() >= n && s.compare(s.size() - n, n, suffix) == 0;
+    }
+
+    // Files named directly, plus the .bhr files in any directory, in name order
+    void collect(const char *arg, std::vector<std::string> &out)
+    {
+        struct stat st{};
+        if (stat(arg, &st) != 0 || !S_ISDIR(st.st_mode))
+        {
+            out.push_back(arg);
+            return;
+        }
+        std::vector<std::string> names;
+        if (DIR *d = opendir(arg))
+        {
+            while (dirent *e = readdir(d))
+                if (hasSuffix(e->d_name, ".bhr"))
+                    names.push_back(std::string(arg) + "/" + e->d_name);
+            closedir(d);
+        }
+        std::sort(names.begin(), names.end());
+        out.insert(out.end(), names.begin(), names.end());
+    }
+
+    void printEntry(size_t i, const ArchiveEntry &e)
+    {
+        char when[32] = "-";
+        time_t t = (time_t)e.timeSec;
+        struct tm tm{};
+        if (localtime_r(&t, &tm))
+            std::strftime(when, sizeof when, "%Y-%m-%d %H:%M", &tm);
+        std::printf("%6zu  %-16s  %7d  %6u  %10llu  %3dx%-3d  %10u  %s\n", i, when, e.score, e.length,
+                    (unsigned long long)e.ticks, e.width, e.height, e.seed, e.name[0] ? e.name : "-");
+    }
+
+    void printHeading()
+    {
+        std::printf("%6s  %-16s  %7s  %6s  %10s  %7s  %10s  %s\n", "#", "date", "score", "length", "ticks", "board",
+                    "seed", "player");
+    }
+
+    int pack(int argc, char **argv)
+    {
+        if (argc < 4)
+        {
+            usage(argv[0]);
+            return 2;
+        }
+        std::vector<std::string> files;
+        for (int i = 3; i < argc; ++i)
+            collect(argv[i], files);
+
+        ReplayArchiveWriter w;
+        if (!w.open(argv[2]))
+        {
+            std::fprintf(stderr, "cannot create %s\n", argv[2]);
+            return 1;
+        }
+        size_t skipped = 0;
+        for (const std::string &f : files)
+        {
+            Replay r;
+            if (!r.open(f) || !w.add(r))
+            {
+                std::fprintf(stderr, "skipping %s: not a valid replay\n", f.c_str());
+                ++skipped;
+            }
+        }
+        if (!w.finish())
+        {
+            std::fprintf(stderr, "cannot write %s\n", argv[2]);
+            return 1;
+        }
+        uint64_t raw = w.rawTurnBytes(), coded = w.codedTurnBytes();
+        std::printf("%zu replays (%zu skipped): turns %llu -> %llu bytes (%.2fx)\n", w.size(), skipped,
+                    (unsigned long long)raw, (unsigned long long)coded, coded ? (double)raw / (double)coded : 0.0);
+        return skipped ? 1 : 0;
+    }
+
+    bool openArchive(ReplayArchive &a, const char *path)
+    {
+        if (a.open(path))
+            return true;
+        std::fprintf(stderr, "not a replay archive: %s\n", path);
+        return false;
+    }
+
+    int list(int argc, char **argv)
+    {
+        if (argc != 3)
+        {
+            usage(argv[0]);
+            return 2;
+        }
+        ReplayArchive a;
+        if (!openArchive(a, argv[2]))
+            return 1;
+        printHeading();
+        for (size_t i = 0; i < a.size(); ++i)
+            printEntry(i, a.entry(i));
+        return 0;
+    }
+
+    // Filters and orders the index alone; no payload is touched
+    int query(int argc, char **argv)
+    {
+        if (argc < 3)
+        {
+            usage(argv[0]);
+            return 2;
+        }
+        int width = 0, height = 0;
+        const char *player = nullptr;
+        bool bySeed = false;
+        unsigned seed = 0;
+        uint64_t since = 0;
+        std::string by = "score";
+        size_t top = 100;
+        for (int i = 3; i < argc; ++i)
+        {
+            std::string a = argv[i];
+            bool more = i + 1 < argc;
+            if (a == "--board" && more && std::sscanf(argv[i + 1], "%dx%d", &width, &height) == 2)
+                ++i;
+            else if (a == "--player" && more)
+                player = argv[++i];
+            else if (a == "--seed" && more)
+            {
+                seed = (unsigned)std::strtoul(argv[++i], nullptr, 10);
+                bySeed = true;
+            }
+            else if (a == "--since" && more)
+            {
+                struct tm tm{};
+                if (!strptime(argv[++i], "%Y-%m-%d", &tm))
+                {
+                    usage(argv[0]);
+                    return 2;
+                }
+                tm.tm_isdst = -1;
+                since = (uint64_t)mktime(&tm);
+            }
+            else if (a == "--by" && more)
+                by = argv[++i];
+            else if (a == "--top" && more)
+                top = (size_t)std::strtoull(argv[++i], nullptr, 10);
+            else
+            {
+                usage(argv[0]);
+                return 2;
+            }
+        }
+        if (by != "score" && by != "length" && by != "ticks" && by != "date")
+        {
+            usage(argv[0]);
+            return 2;
+        }
+
+        ReplayArchive a;
+        if (!openArchive(a, argv[2]))
+            return 1;
+        std::vector<uint32_t> hits;
+        for (size_t i = 0; i < a.size(); ++i)
+        {
+            const ArchiveEntry &e = a.entry(i);
+            if (width && (e.width != width || e.height != height))
+                continue;
+            if (player && std::strncmp(e.name, player, sizeof e.name) != 0)
+                continue;
+            if (bySeed && e.seed != seed)
+                continue;
+            if (e.timeSec < since)
+                continue;
+            hits.push_back((uint32_t)i);
+        }
+
+        auto key = [&](uint32_t i) -> uint64_t
+        {
+            const ArchiveEntry &e = a.entry(i);
+            if (by == "length")
+                return e.length;
+            if (by == "ticks")
+                return e.ticks;
+            if (by == "date")
+                return e.timeSec;
+            return (uint64_t)(int64_t)e.score + (1ull << 63); // order-preserving for negatives
+        };
+        // Best first; ties keep archive order
+        size_t n = std::min(top, hits.size());
+        std::partial_sort(hits.begin(), hits.begin() + (std::ptrdiff_t)n, hits.end(), [&](uint32_t x, uint32_t y)
+                          {
+                              uint64_t kx = key(x), ky = key(y);
+                              return kx != ky ? kx > ky : x < y; });
+        printHeading();
+        for (size_t i = 0; i < n; ++i)
+            printEntry(hits[i], a.entry(hits[i]));
+        return 0;
+    }
+
+    int extract(int argc, char **argv)
+    {
+        if (argc != 5)
+        {
+            usage(argv[0]);
+            return 2;
+        }
+        ReplayArchive a;
+        if (!openArchive(a, argv[2]))
+            return 1;
+        char *end = nullptr;
+        unsigned long long i = std::strtoull(argv[3], &end, 10);
+        std::vector<uint8_t> file;
+        if (*end || i >= a.size() || !a.extract((size_t)i, file))
+        {
+            std::fprintf(stderr, "no replay %s in %s\n", argv[3], argv[2]);
+            return 1;
+        }
+        FILE *f = std::fopen(argv[4], "wb");
+        bool ok = f && std::fwrite(file.data(), 1, file.size(), f) == file.size();
+        if (f)
+            ok = std::fclose(f) == 0 && ok;
+        if (!ok)
+        {
+            std::fprintf(stderr, "cannot write %s\n", argv[4]);
+            return 1;
+        }
+        return 0;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    std::string cmd = argc > 1 ? argv[1] : "";
+    if (cmd == "pack")
+        return pack(argc, argv);
+    if (cmd == "list")
+        return list(argc, argv);
+    if (cmd == "query")
+        return query(argc, argv);
+    if (cmd == "extract")
+        return extract(argc, argv);
+    usage(argv[0]);
+    return 2;
+}
@@ -0,0 +1,255 @@
+// Replay verifier: re-runs replays through the game rules on every core and
+// reports any whose claimed ticks, score or length don't reproduce
+#include "replay_archive.h"
+#include "work_pool.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <dirent.h>
+#include <sys/stat.h>
+
+namespace
+{
+    void usage(const char *argv0)
+    {
+        std::fprintf(stderr,
+                     "usage: %s [--threads N] [--verbose] [--level FILE]... FILE.bhr|ARCHIVE.bha|DIR...\n"
+                     "  --level FILE  a level that replays may have been recorded on\n",
+                     argv0);
+    }
+
+    bool hasSuffix(const std::string &s, const char *suffix)
+    {
+        size_t n = std::strlen(suffix);
+        return s.size() >= n && s.compare(s.size() - n, n, suffix) == 0;
+    }
+
+    // One replay: a .bhr file, or entry `index` of an archive
+    struct Job
+    {
+        int archive{-1};
+        size_t index{0};
+        std::string path;
+    };
+
+    struct Result
+    {
+        bool opened{false};
+        bool noLevel{false}; // recorded on a level not given with --level
+        ReplayHeader claimed{};
+        ReplayCheck check;
+    };
+
+    // Replay files and archives named directly or found in a directory
+    void collect(const char *arg, std::vector<std::string> &out)
+    {
+        struct stat st{};
+        if (stat(arg, &st) != 0 || !S_ISDIR(st.st_mode))
+        {
+            out.push_back(arg);
+            return;
+        }
+        std::vector<std::string> names;
+        if (DIR *d = opendir(arg))
+        {
+            while (dirent *e = readdir(d))
+                if (hasSuffix(e->d_name, ".bhr") || hasSuffix(e->d_name, ".bha"))
+                    names.push_back(std::string(arg) + "/" + e->d_name);
+            closedir(d);
+        }
+        std::sort(names.begin(), names.end());
+        out.insert(out.end(), names.begin(), names.end());
+    }
+
+    // Boards rebuilt from replay headers, kept per worker: a batch usually
+    // mixes a handful of board sizes, and each board builds a neighbour table
+    struct BoardCache
+    {
+        static constexpr size_t kBoards = 8;
+        std::vector<Level> boards;
+        size_t next{0};
+        Level none; // stays empty
+    };
+
+    // The board h was recorded on: the plain or a generated board, from
+    // cache, or one of levels (nullptr if not given). A header whose board
+    // can't be rebuilt gets an empty one, which checkReplay() rejects.
+    const Level *boardOf(const ReplayHeader &h, const std::vector<std::unique_ptr<Level>> &levels, BoardCache &cache)
+    {
+        if (h.level == 0 || h.generator)
+        {
+            for (const Level &b : cache.boards)
+                if (levelMatches(h, b) && b.generator() == h.generator)
+                    return &b;
+            Level b;
+            if (!replayBoard(h, b))
+                return &cache.none;
+            if (cache.boards.size() < BoardCache::kBoards)
+            {
+                cache.boards.push_back(std::move(b));
+                return &cache.boards.back();
+            }
+            Level &slot = cache.boards[cache.next++ % BoardCache::kBoards];
+            slot = std::move(b);
+            return &slot;
+        }
+        for (const auto &l : levels)
+            if (l->id() == h.level)
+                return l.get();
+        return nullptr;
+    }
+
+    std::string describe(const Job &j, const std::vector<std::string> &archiveNames)
+    {
+        if (j.archive < 0)
+            return j.path;
+        return archiveNames[(size_t)j.archive] + "#" + std::to_string(j.index);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    unsigned threads = 0;
+    bool verbose = false;
+    std::vector<std::string> inputs;
+    std::vector<std::unique_ptr<Level>> levels;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string a = argv[i];
+        if (a == "--threads" && i + 1 < argc)
+            threads = (unsigned)std::strtoul(argv[++i], nullptr, 10);
+        else if (a == "--level" && i + 1 < argc)
+        {
+            std::unique_ptr<Level> l(new Level);
+            if (!l->open(argv[++i]))
+            {
+                std::fprintf(stderr, "not a level file: %s\n", argv[i]);
+                return 1;
+            }
+            levels.push_back(std::move(l));
+        }
+        else if (a == "--verbose")
+            verbose = true;
+        else if (!a.empty() && a[0] == '-')
+        {
+            usage(argv[0]);
+            return 2;
+        }
+        else
+            collect(argv[i], inputs);
+    }
+    if (inputs.empty())
+    {
+        usage(argv[0]);
+        return 2;
+    }
+
+    // Archives stay mapped for the whole run; their entries become jobs
+    std::vector<std::unique_ptr<ReplayArchive>> archives;
+    std::vector<std::string> archiveNames;
+    std::vector<Job> jobs;
+    for (const std::string &in : inputs)
+    {
+        std::unique_ptr<ReplayArchive> a(new ReplayArchive);
+        if (a->open(in))
+        {
+            for (size_t i = 0; i < a->size(); ++i)
+                jobs.push_back(Job{(int)archives.size(), i, std::string()});
+            archives.push_back(std::move(a));
+            archiveNames.push_back(in);
+        }
+        else
+            jobs.push_back(Job{-1, 0, in});
+    }
+
+    WorkPool pool(threads);
+    std::vector<Result> results(jobs.size());
+    std::vector<std::vector<uint8_t>> scratch(pool.threads());
+    std::vector<BoardCache> boards(pool.threads());
+    std::atomic<uint64_t> ticks{0};
+    auto t0 = std::chrono::steady_clock::now();
+    pool.run(jobs.size(), [&](size_t i, unsigned worker)
+             {
+                 const Job &j = jobs[i];
+                 Result &r = results[i];
+                 const Level *level = nullptr;
+                 if (j.archive >= 0)
+                 {
+                     std::vector<uint8_t> &file = scratch[worker];
+                     if (!archives[(size_t)j.archive]->extract(j.index, file))
+                         return;
+                     std::memcpy(&r.claimed, file.data(), sizeof r.claimed);
+                     if (!(level = boardOf(r.claimed, levels, boards[worker])))
+                     {
+                         r.noLevel = true;
+                         return;
+                     }
+                     r.check = checkReplay(r.claimed, *level, file.data() + sizeof r.claimed,
+                                           file.size() - sizeof r.claimed);
+                 }
+                 else
+                 {
+                     Replay replay;
+                     if (!replay.open(j.path))
+                         return;
+                     r.claimed = replay.header();
+                     if (!(level = boardOf(r.claimed, levels, boards[worker])))
+                     {
+                         r.noLevel = true;
+                         return;
+                     }
+                     r.check = checkReplay(r.claimed, *level, replay.turns(), replay.turnBytes());
+                 }
+                 r.opened = true;
+                 ticks.fetch_add(r.check.ticks, std::memory_order_relaxed); });
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    size_t bad = 0, unreadable = 0;
+    for (size_t i = 0; i < jobs.size(); ++i)
+    {
+        const Result &r = results[i];
+        std::string name = describe(jobs[i], archiveNames);
+        if (r.noLevel)
+        {
+            ++unreadable;
+            std::printf("UNREADABLE %s  recorded on level %016llx; pass it with --level\n", name.c_str(),
+                        (unsigned long long)r.claimed.level);
+            continue;
+        }
+        if (!r.opened)
+        {
+            ++unreadable;
+            std::printf("UNREADABLE %s\n", name.c_str());
+            continue;
+        }
+        const ReplayHeader &h = r.claimed;
+        const ReplayCheck &c = r.check;
+        if (c.matches(h))
+        {
+            if (verbose)
+                std::printf("ok         %s  score %d  ticks %llu\n", name.c_str(), h.score, (unsigned long long)h.ticks);
+            continue;
+        }
+        ++bad;
+        if (!c.valid)
+            std::printf("MISMATCH   %s  invalid board %dx%d\n", name.c_str(), h.width, h.height);
+        else
+            std::printf("MISMATCH   %s  claimed score %d length %u ticks %llu, replayed score %d length %u ticks %llu%s\n",
+                        name.c_str(), h.score, h.length, (unsigned long long)h.ticks, c.score, c.length,
+                        (unsigned long long)c.ticks,
+                        c.alive ? ", still alive" : c.turnsLeft ? ", turns after death" : "");
+    }
+
+    uint64_t total = ticks.load();
+    std::printf("%zu replays, %zu verified, %zu mismatched, %zu unreadable; %llu ticks in %.3f s (%.1f Mticks/s, %u threads)\n",
+                jobs.size(), jobs.size() - bad - unreadable, bad, unreadable, (unsigned long long)total, seconds,
+                seconds > 0 ? (double)total / seconds / 1e6 : 0.0, pool.threads());
+    return bad || unreadable ? 1 : 0;
+}
@@ -0,0 +1,195 @@
+// Replay to video: one frame per tick as a Y4M stream or numbered PPM images,
+// rendered on a work-stealing pool and written in order
+#include "replay.h"
+#include "video.h"
+#include "work_pool.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <sys/stat.h>
+
+namespace
+{
+    void usage(const char *argv0)
+    {
+        std::fprintf(stderr,
+                     "usage: %s REPLAY.bhr (--y4m OUT.y4m | --ppm DIR) [--cell PX] [--from TICK] [--to TICK]\n"
+                     "          [--step N] [--threads N] [--level FILE]\n"
+                     "  --y4m OUT   raw 4:2:0 video, one frame per tick at the recorded rate (\"-\" = stdout)\n"
+                     "  --ppm DIR   DIR/frame-000000.ppm, ...\n"
+                     "  --cell PX   pixels per board cell (default 8)\n"
+                     "  --step N    one frame every N ticks (default 1; the frame rate stays real time)\n"
+                     "  --level F   the level the replay was recorded on, if any\n",
+                     argv0);
+    }
+
+    bool writeAll(FILE *f, const std::vector<uint8_t> &b)
+    {
+        return std::fwrite(b.data(), 1, b.size(), f) == b.size();
+    }
+}
+
+int main(int argc, char **argv)
+{
+    const char *replayPath = nullptr;
+    const char *y4mPath = nullptr;
+    const char *ppmDir = nullptr;
+    const char *levelPath = nullptr;
+    int cell = 8;
+    uint64_t from = 0, to = ~0ull, step = 1;
+    unsigned threads = 0;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string a = argv[i];
+        bool more = i + 1 < argc;
+        if (a == "--y4m" && more)
+            y4mPath = argv[++i];
+        else if (a == "--ppm" && more)
+            ppmDir = argv[++i];
+        else if (a == "--cell" && more)
+            cell = std::atoi(argv[++i]);
+        else if (a == "--from" && more)
+            from = std::strtoull(argv[++i], nullptr, 10);
+        else if (a == "--to" && more)
+            to = std::strtoull(argv[++i], nullptr, 10);
+        else if (a == "--step" && more)
+            step = std::max<uint64_t>(1, std::strtoull(argv[++i], nullptr, 10));
+        else if (a == "--level" && more)
+            levelPath = argv[++i];
+        else if (a == "--threads" && more)
+            threads = (unsigned)std::strtoul(argv[++i], nullptr, 10);
+        else if (!replayPath && a[0] != '-')
+            replayPath = argv[i];
+        else
+        {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (!replayPath || !y4mPath == !ppmDir || cell < 1 || cell > 64)
+    {
+        usage(argv[0]);
+        return 2;
+    }
+
+    Replay replay;
+    if (!replay.open(replayPath))
+    {
+        std::fprintf(stderr, "not a replay file: %s\n", replayPath);
+        return 1;
+    }
+    const ReplayHeader &h = replay.header();
+    Level level;
+    if (levelPath && !level.open(levelPath))
+    {
+        std::fprintf(stderr, "not a level file: %s\n", levelPath);
+        return 1;
+    }
+    if (!levelPath)
+        replayBoard(h, level);
+    if (!levelMatches(h, level))
+    {
+        std::fprintf(stderr, "%s was recorded on level %016llx; pass that level with --level\n", replayPath,
+                     (unsigned long long)h.level);
+        return 1;
+    }
+    FrameRasterizer raster(level, cell);
+
+    FILE *out = nullptr;
+    if (y4mPath)
+    {
+        out = std::strcmp(y4mPath, "-") == 0 ? stdout : std::fopen(y4mPath, "wb");
+        if (!out)
+        {
+            std::fprintf(stderr, "cannot create %s\n", y4mPath);
+            return 1;
+        }
+        std::string header = raster.y4mHeader(1000, h.tickMs * (int)step);
+        std::fwrite(header.data(), 1, header.size(), out);
+    }
+    else
+        mkdir(ppmDir, 0755);
+
+    WorkPool pool(threads);
+    // Batches: simulate ahead on this thread, render in parallel, write in order
+    const size_t batchSize = 16 * pool.threads();
+    std::vector<VideoFrame> frames(batchSize);
+    std::vector<std::vector<uint8_t>> encoded(batchSize);
+    std::vector<std::vector<uint8_t>> scratch(pool.threads());
+
+    Snake snake(level.spawn().x, level.spawn().y, 3, (size_t)h.width * (size_t)h.height);
+    Fruit fruit(h.width, h.height, h.seed);
+    ReplayCursor cursor;
+    replayStart(replay, level, snake, fruit, cursor);
+    int score = 0;
+    uint64_t tick = 0, written = 0;
+    bool ended = false;
+    const uint64_t last = std::min<uint64_t>(to, h.ticks);
+    auto t0 = std::chrono::steady_clock::now();
+    bool ok = true;
+    while (ok && !ended && tick <= last)
+    {
+        size_t n = 0;
+        while (n < batchSize && !ended && tick <= last)
+        {
+            if (tick >= from && (tick - from) % step == 0)
+            {
+                VideoFrame &f = frames[n++];
+                f.tick = tick;
+                const Point *a, *b;
+                size_t na, nb;
+                snake.segments().runs(a, na, b, nb);
+                f.body.assign(a, a + na);
+                f.body.insert(f.body.end(), b, b + nb);
+                f.dir = snake.getDirection();
+                f.fruit = fruit.position();
+            }
+            // The fatal tick leaves the board as it was, so the last frame
+            // shows the final position
+            Direction d;
+            if (cursor.turnAt(tick + 1, d))
+                snake.setDirection(d);
+            if (isDeath(stepRules(level, snake, fruit, score)))
+                ended = true;
+            ++tick;
+        }
+
+        VideoFormat format = y4mPath ? VideoFormat::Y4M : VideoFormat::PPM;
+        pool.run(n, [&](size_t i, unsigned worker)
+                 { raster.encode(frames[i], format, scratch[worker], encoded[i]); });
+
+        for (size_t i = 0; i < n && ok; ++i, ++written)
+        {
+            if (out)
+            {
+                ok = writeAll(out, encoded[i]);
+                continue;
+            }
+            char path[4096];
+            std::snprintf(path, sizeof path, "%s/frame-%06llu.ppm", ppmDir, (unsigned long long)written);
+            FILE *f = std::fopen(path, "wb");
+            ok = f && writeAll(f, encoded[i]);
+            if (f)
+                ok = std::fclose(f) == 0 && ok;
+        }
+    }
+    if (out && out != stdout)
+        ok = std::fclose(out) == 0 && ok;
+    else if (out)
+        ok = std::fflush(out) == 0 && ok;
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    if (!ok)
+    {
+        std::fprintf(stderr, "write failed after %llu frames\n", (unsigned long long)written);
+        return 1;
+    }
+    std::fprintf(stderr, "%llu frames, %dx%d px, %.2f s (%.0f frames/s, %u threads)\n", (unsigned long long)written,
+                 raster.pixelWidth(), raster.pixelHeight(), seconds, seconds > 0 ? (double)written / seconds : 0.0,
+                 pool.threads());
+    return 0;
+}